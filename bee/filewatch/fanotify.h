@@ -0,0 +1,58 @@
+#pragma once
+
+#include <bee/filewatch/glob_filter.h>
+#include <bee/filewatch/notify_queue.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bee::filewatch {
+    // Whole-filesystem watch through fanotify: one FAN_MARK_FILESYSTEM mark
+    // covers every directory on the filesystem holding a root, so no
+    // per-directory watches (and no max_user_watches limit) are involved.
+    // Events carry the directory file handle plus the entry name; handles
+    // are resolved to paths with open_by_handle_at and cached. Needs
+    // CAP_SYS_ADMIN and Linux 5.9+; init() fails otherwise, including on
+    // kernels that let unprivileged callers init but not mark.
+    class fanotify {
+    public:
+        fanotify() noexcept = default;
+        ~fanotify() noexcept;
+        fanotify(const fanotify&)            = delete;
+        fanotify& operator=(const fanotify&) = delete;
+
+        bool init() noexcept;
+        void stop() noexcept;
+        bool add(const std::string& path);
+        void set_recursive(bool enable) noexcept;
+        // drops cached directory decisions after the filters changed.
+        void invalidate() noexcept;
+        int fd() const noexcept;
+        using filter = std::function<bool(const char*)>;
+        // drains the kernel queue into q, dropping directories (and their
+        // subtrees) below a root that filter rejects and paths that glob
+        // excludes; returns false if the kernel lost events.
+        bool read(notify_queue& q, uint64_t now, const filter& f, const glob_filter& glob);
+
+    private:
+        struct mount {
+            uint64_t fsid;
+            int fd;
+        };
+        struct dir {
+            std::string path;
+            bool accepted;
+        };
+        const dir* resolve(uint64_t fsid, const void* handle, const filter& f, const glob_filter& glob);
+        bool accept(const std::string& path, const filter& f, const glob_filter& glob) const;
+
+        int m_fd         = -1;
+        bool m_recursive = true;
+        std::vector<std::string> m_roots;
+        std::vector<mount> m_mounts;
+        std::unordered_map<std::string, dir> m_dirs;
+    };
+}
@@ -0,0 +1,228 @@
+#include <bee/filewatch/fanotify.h>
+#include <fcntl.h>
+#include <sys/fanotify.h>
+#include <sys/statfs.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+namespace bee::filewatch {
+    static constexpr size_t kMaxCachedDirs = 64 * 1024;
+
+    static constexpr uint64_t kEventMask = FAN_CREATE | FAN_DELETE | FAN_MOVED_FROM | FAN_MOVED_TO | FAN_MODIFY | FAN_ATTRIB | FAN_CLOSE_WRITE | FAN_ONDIR;
+
+    fanotify::~fanotify() noexcept {
+        stop();
+    }
+
+    bool fanotify::init() noexcept {
+#if defined(FAN_REPORT_DFID_NAME)
+        m_fd = fanotify_init(FAN_CLASS_NOTIF | FAN_REPORT_DFID_NAME | FAN_NONBLOCK | FAN_CLOEXEC, O_RDONLY | O_CLOEXEC);
+        if (m_fd == -1) {
+            return false;
+        }
+        // since 5.13 an unprivileged fanotify_init succeeds, but filesystem
+        // marks still need CAP_SYS_ADMIN. Removing a mark that was never
+        // added fails with ENOENT once that check has passed, EPERM before.
+        if (fanotify_mark(m_fd, FAN_MARK_REMOVE | FAN_MARK_FILESYSTEM, kEventMask, AT_FDCWD, "/") != 0 && errno == EPERM) {
+            stop();
+            return false;
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void fanotify::stop() noexcept {
+        for (auto& m : m_mounts) {
+            ::close(m.fd);
+        }
+        m_mounts.clear();
+        m_roots.clear();
+        m_dirs.clear();
+        if (m_fd != -1) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    bool fanotify::add(const std::string& path) {
+        if (m_fd == -1) {
+            return false;
+        }
+        struct statfs st;
+        if (::statfs(path.c_str(), &st) != 0) {
+            return false;
+        }
+        uint64_t fsid;
+        static_assert(sizeof(fsid) == sizeof(st.f_fsid));
+        memcpy(&fsid, &st.f_fsid, sizeof(fsid));
+        bool marked = false;
+        for (auto& m : m_mounts) {
+            if (m.fsid == fsid) {
+                marked = true;
+                break;
+            }
+        }
+        if (!marked) {
+            int mount_fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (mount_fd == -1) {
+                return false;
+            }
+            if (fanotify_mark(m_fd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, kEventMask, AT_FDCWD, path.c_str()) != 0) {
+                ::close(mount_fd);
+                return false;
+            }
+            m_mounts.push_back({ fsid, mount_fd });
+        }
+        m_roots.push_back(path);
+        return true;
+    }
+
+    void fanotify::set_recursive(bool enable) noexcept {
+        m_recursive = enable;
+    }
+
+    void fanotify::invalidate() noexcept {
+        m_dirs.clear();
+    }
+
+    int fanotify::fd() const noexcept {
+        return m_fd;
+    }
+
+    bool fanotify::accept(const std::string& path, const filter& f, const glob_filter& glob) const {
+        for (auto& root : m_roots) {
+            if (path.size() < root.size() || path.compare(0, root.size(), root) != 0) {
+                continue;
+            }
+            if (path.size() == root.size()) {
+                return true;
+            }
+            if (!m_recursive || (root.back() != '/' && path[root.size()] != '/')) {
+                continue;
+            }
+            // inotify never descends into a rejected directory; hide the same subtrees.
+            if (glob.excluded(path, true)) {
+                return false;
+            }
+            for (size_t pos = path.find('/', root.size() + 1); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+                if (!f(path.substr(0, pos).c_str())) {
+                    return false;
+                }
+            }
+            return f(path.c_str());
+        }
+        return false;
+    }
+
+    const fanotify::dir* fanotify::resolve(uint64_t fsid, const void* handle, const filter& f, const glob_filter& glob) {
+        struct file_handle fh;
+        memcpy(&fh, handle, sizeof(fh));
+        size_t size = sizeof(fh) + fh.handle_bytes;
+        std::string key((const char*)&fsid, sizeof(fsid));
+        key.append((const char*)handle, size);
+        auto it = m_dirs.find(key);
+        if (it != m_dirs.end()) {
+            return &it->second;
+        }
+        int mount_fd = -1;
+        for (auto& m : m_mounts) {
+            if (m.fsid == fsid) {
+                mount_fd = m.fd;
+                break;
+            }
+        }
+        if (mount_fd == -1) {
+            return nullptr;
+        }
+        // the handle inside the event record is not aligned for struct file_handle.
+        std::vector<uint64_t> storage((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        memcpy(storage.data(), handle, size);
+        int fd = open_by_handle_at(mount_fd, (struct file_handle*)storage.data(), O_PATH | O_CLOEXEC);
+        if (fd == -1) {
+            return nullptr;
+        }
+        char link[64];
+        snprintf(link, sizeof(link), "/proc/self/fd/%d", fd);
+        char buf[4096];
+        ssize_t n = ::readlink(link, buf, sizeof(buf));
+        ::close(fd);
+        if (n <= 0 || (size_t)n >= sizeof(buf)) {
+            return nullptr;
+        }
+        std::string path(buf, (size_t)n);
+        bool accepted = accept(path, f, glob);
+        if (m_dirs.size() >= kMaxCachedDirs) {
+            m_dirs.clear();
+        }
+        auto r = m_dirs.emplace(std::move(key), dir { std::move(path), accepted });
+        return &r.first->second;
+    }
+
+    bool fanotify::read(notify_queue& q, uint64_t now, const filter& f, const glob_filter& glob) {
+        bool complete = true;
+#if defined(FAN_REPORT_DFID_NAME)
+        alignas(fanotify_event_metadata) char buf[16 * 1024];
+        for (;;) {
+            ssize_t len = ::read(m_fd, buf, sizeof(buf));
+            if (len <= 0) {
+                break;
+            }
+            auto md = (const struct fanotify_event_metadata*)buf;
+            for (; FAN_EVENT_OK(md, len); md = FAN_EVENT_NEXT(md, len)) {
+                if (md->fd >= 0) {
+                    ::close(md->fd);
+                }
+                if (md->mask & FAN_Q_OVERFLOW) {
+                    complete = false;
+                    continue;
+                }
+                auto info = (const struct fanotify_event_info_fid*)(md + 1);
+                if ((const char*)(info + 1) > (const char*)md + md->event_len || info->hdr.info_type != FAN_EVENT_INFO_TYPE_DFID_NAME) {
+                    continue;
+                }
+                struct file_handle fh;
+                memcpy(&fh, info->handle, sizeof(fh));
+                const char* name = (const char*)info->handle + sizeof(fh) + fh.handle_bytes;
+                uint64_t fsid;
+                memcpy(&fsid, &info->fsid, sizeof(fsid));
+                const dir* d = resolve(fsid, info->handle, f, glob);
+                if (!d || !d->accepted) {
+                    continue;
+                }
+                std::string path = strcmp(name, ".") == 0 ? d->path : d->path + "/" + name;
+                if ((md->mask & FAN_ONDIR) && (md->mask & (FAN_DELETE | FAN_MOVED_FROM | FAN_MOVED_TO))) {
+                    // cached directory paths below a moved or removed directory are stale now.
+                    m_dirs.clear();
+                }
+                if (glob.excluded(path, md->mask & FAN_ONDIR)) {
+                    continue;
+                }
+                // the kernel merges events on the same entry; replay them in a plausible order.
+                if (md->mask & FAN_CREATE) {
+                    q.push(notify_queue::event::created, path, now);
+                }
+                if (md->mask & (FAN_MOVED_FROM | FAN_MOVED_TO)) {
+                    q.push(notify_queue::event::renamed, path, now);
+                }
+                if (md->mask & (FAN_MODIFY | FAN_ATTRIB | FAN_CLOSE_WRITE)) {
+                    q.push(notify_queue::event::modified, path, now);
+                }
+                if (md->mask & FAN_DELETE) {
+                    q.push(notify_queue::event::removed, path, now);
+                }
+            }
+        }
+#else
+        (void)q;
+        (void)now;
+        (void)f;
+        (void)glob;
+#endif
+        return complete;
+    }
+}
@@ -1,19 +1,34 @@
 #pragma once
 
+#include <bee/filewatch/glob_filter.h>
+#include <bee/filewatch/notify_queue.h>
+
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <mutex>
 #include <optional>
-#include <queue>
 #include <string>
+#include <vector>
 
 #if defined(_WIN32)
 #    include <list>
 #elif defined(__APPLE__)
 #    include <CoreServices/CoreServices.h>
 
+#    include <condition_variable>
 #    include <set>
 #elif defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
-#    include <map>
+#    include <bee/filewatch/path_tree.h>
+#    include <bee/filewatch/snapshot.h>
+#    if defined(__linux__)
+#        include <bee/filewatch/fanotify.h>
+
+#        include <memory>
+#    endif
+
+#    include <string_view>
+#    include <unordered_map>
 #else
 #    error unsupport platform
 #endif
@@ -23,18 +38,6 @@ struct lua_State;
 namespace bee::filewatch {
     class task;
 
-    struct notify {
-        enum class flag {
-            modify,
-            rename,
-        };
-        flag flags;
-        std::string path;
-        notify(const flag& flags, const std::string& path)
-            : flags(flags)
-            , path(path) {}
-    };
-
     class watch {
     public:
 #if defined(_WIN32)
@@ -44,22 +47,48 @@ namespace bee::filewatch {
 #endif
         using filter = std::function<bool(const char*)>;
         static const char* type() noexcept;
+        // the backend this instance actually uses; differs from type() once
+        // use_fanotify() has succeeded.
+        const char* backend() const noexcept;
         static inline filter DefaultFilter = [](const char*) { return true; };
 
         watch() noexcept;
         ~watch();
 
         void stop() noexcept;
+        // switches to one whole-filesystem fanotify mark per watched
+        // filesystem. Only possible before the first add(); returns false
+        // (and keeps the default backend) without the kernel support or
+        // privileges for it.
+        bool use_fanotify();
         void add(const string_type& path);
         void set_recursive(bool enable) noexcept;
         bool set_follow_symlinks(bool enable) noexcept;
         bool set_filter(filter f = DefaultFilter);
+        // gitignore-style rules (see glob_filter) checked natively while the
+        // tree is registered and before events are queued; they apply on
+        // top of the filter callback. An empty list removes them.
+        bool set_rules(const std::vector<std::string>& rules);
+        // events for a path are held until it has been quiet for ms, but
+        // no longer than max_ms after the first of them.
+        void set_quiet_period(uint64_t ms, uint64_t max_ms);
+        // 0 means unbounded; past the limit the queue collapses into one overflow notify.
+        void set_queue_limit(size_t limit);
+        // keeps a listing of every watched directory so that a lost event
+        // stream is answered with the actual differences instead of overflow.
+        bool set_rescan(bool enable);
         void update();
         std::optional<notify> select();
+        // pollable descriptor that turns readable when update() has work,
+        // or -1 when the backend has none.
+        int fd() const noexcept;
+        // blocks up to timeout milliseconds (-1 forever) for notifications
+        // and returns whether any are queued. It may return early.
+        bool wait(int timeout);
 
     private:
 #if defined(_WIN32)
-        bool event_update(task& task);
+        bool event_update(task& task, uint64_t now);
 #elif defined(__APPLE__)
         bool create_stream(CFArrayRef cf_paths) noexcept;
         void destroy_stream() noexcept;
@@ -70,24 +99,36 @@ namespace bee::filewatch {
 
     private:
 #elif defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
-        void event_update(void* event);
+        void event_update(void* event, uint64_t now);
+        void rescan(uint64_t now);
+        path_tree::node_id add_watch(const std::string& path, path_tree::node_id parent, std::string_view name);
+        void add_subtree(path_tree::node_id node, const std::string& path);
 #endif
 
     private:
-        std::queue<notify> m_notify;
+        notify_queue m_notify;
+        glob_filter m_glob;
         bool m_recursive = true;
 #if defined(_WIN32)
         std::list<task> m_tasks;
 #elif defined(__APPLE__)
         std::mutex m_mutex;
+        std::condition_variable m_cond;
         std::set<std::string> m_paths;
         FSEventStreamRef m_stream;
         dispatch_queue_t m_fsevent_queue;
 #elif defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
-        std::map<int, std::string> m_fd_path;
+        std::unordered_map<int, path_tree::node_id> m_wd_node;
+        path_tree m_tree;
+        snapshot m_snapshot;
         int m_inotify_fd;
         bool m_follow_symlinks = false;
+        bool m_rescan          = false;
+        bool m_lost            = false;
         filter m_filter        = DefaultFilter;
+#    if defined(__linux__)
+        std::unique_ptr<fanotify> m_fanotify;
+#    endif
 #endif
     };
 }
@@ -2,22 +2,57 @@
 #include <bee/filewatch/filewatch.h>
 #include <bee/nonstd/filesystem.h>
 #include <bee/nonstd/unreachable.h>
+#include <bee/thread/simplethread.h>
+#include <bee/time/monotonic.h>
 #include <poll.h>
 #include <sys/inotify.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <functional>
+#include <thread>
+#include <vector>
 
 namespace bee::filewatch {
     const char* watch::type() noexcept {
         return "inotify";
     }
 
+    const char* watch::backend() const noexcept {
+#if defined(__linux__)
+        if (m_fanotify) {
+            return "fanotify";
+        }
+#endif
+        return type();
+    }
+
+    bool watch::use_fanotify() {
+#if defined(__linux__)
+        if (m_fanotify) {
+            return true;
+        }
+        if (m_inotify_fd == -1 || !m_wd_node.empty()) {
+            return false;
+        }
+        auto f = std::make_unique<fanotify>();
+        if (!f->init()) {
+            return false;
+        }
+        f->set_recursive(m_recursive);
+        m_fanotify = std::move(f);
+        return true;
+#else
+        return false;
+#endif
+    }
+
     watch::watch() noexcept
         : m_notify()
-        , m_fd_path()
+        , m_wd_node()
         , m_inotify_fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {
         assert(m_inotify_fd != -1);
     }
@@ -30,15 +65,108 @@ namespace bee::filewatch {
         if (m_inotify_fd == -1) {
             return;
         }
-        for (auto& [desc, _] : m_fd_path) {
+#if defined(__linux__)
+        m_fanotify.reset();
+#endif
+        for (auto& [desc, _] : m_wd_node) {
             (void)_;
             inotify_rm_watch(m_inotify_fd, desc);
         }
-        m_fd_path.clear();
+        m_wd_node.clear();
+        m_tree.clear();
+        m_snapshot.clear();
+        m_glob.clear_roots();
         close(m_inotify_fd);
         m_inotify_fd = -1;
     }
 
+    static constexpr size_t kParallelScanMin  = 32;
+    static constexpr unsigned kMaxScanThreads = 8;
+
+    struct subdir {
+        std::string name;
+        bool symlink;
+    };
+
+    static void list_subdirs(const std::string& dir, bool follow_symlinks, std::vector<subdir>& out) {
+        std::error_code ec;
+        fs::directory_iterator iter { fs::path(dir), fs::directory_options::skip_permission_denied, ec };
+        fs::directory_iterator end {};
+        for (; !ec && iter != end; iter.increment(ec)) {
+            std::error_code file_status_ec;
+            auto st      = iter->symlink_status(file_status_ec);
+            bool symlink = fs::is_symlink(st);
+            if (symlink && follow_symlinks) {
+                st = iter->status(file_status_ec);
+            }
+            if (fs::is_directory(st)) {
+                out.push_back({ iter->path().filename().string(), symlink });
+            }
+        }
+    }
+
+    struct scan_job {
+        const std::vector<std::string>* dirs;
+        std::vector<std::vector<subdir>>* found;
+        std::atomic<size_t> next { 0 };
+        bool follow_symlinks;
+    };
+
+    static void scan_worker(void* ud) noexcept {
+        auto& job = *static_cast<scan_job*>(ud);
+        try {
+            for (;;) {
+                size_t i = job.next.fetch_add(1, std::memory_order_relaxed);
+                if (i >= job.dirs->size()) {
+                    return;
+                }
+                list_subdirs((*job.dirs)[i], job.follow_symlinks, (*job.found)[i]);
+            }
+        } catch (...) {
+        }
+    }
+
+    // lists one tree level; wide levels are spread over worker threads since
+    // readdir and stat dominate, while filtering and watch registration stay
+    // on the caller so the Lua filter is never called from another thread.
+    static void scan_level(const std::vector<std::string>& dirs, bool follow_symlinks, std::vector<std::vector<subdir>>& found) {
+        found.assign(dirs.size(), {});
+        scan_job job;
+        job.dirs            = &dirs;
+        job.found           = &found;
+        job.follow_symlinks = follow_symlinks;
+        std::vector<thread_handle> threads;
+        if (dirs.size() >= kParallelScanMin) {
+            unsigned n = (std::min)(std::thread::hardware_concurrency(), kMaxScanThreads);
+            for (unsigned i = 1; i < n; ++i) {
+                if (thread_handle h = thread_create(scan_worker, &job)) {
+                    threads.push_back(h);
+                }
+            }
+        }
+        scan_worker(&job);
+        for (auto h : threads) {
+            thread_wait(h);
+        }
+    }
+
+    path_tree::node_id watch::add_watch(const std::string& path, path_tree::node_id parent, std::string_view name) {
+        int desc = inotify_add_watch(m_inotify_fd, path.c_str(), IN_ALL_EVENTS);
+        if (desc == -1) {
+            return path_tree::npos;
+        }
+        auto [it, inserted] = m_wd_node.emplace(desc, path_tree::npos);
+        if (!inserted) {
+            // already watched, either added twice or reached again through a symlink.
+            return path_tree::npos;
+        }
+        it->second = m_tree.insert(parent, name);
+        if (m_rescan) {
+            m_snapshot.record(path);
+        }
+        return it->second;
+    }
+
     void watch::add(const string_type& str) {
         if (m_inotify_fd == -1) {
             return;
@@ -54,29 +182,73 @@ namespace bee::filewatch {
                 return;
             }
         }
-        int desc = inotify_add_watch(m_inotify_fd, path.c_str(), IN_ALL_EVENTS);
-        if (desc != -1) {
-            const auto& emplace_result = m_fd_path.emplace(std::make_pair(desc, path.string()));
-            if (!emplace_result.second) {
-                return;
-            }
+        std::string root = path.string();
+        if (m_glob.excluded(root, true)) {
+            return;
         }
-        if (!m_recursive) {
+        m_glob.add_root(root);
+#if defined(__linux__)
+        if (m_fanotify) {
+            // the filesystem mark already covers every subdirectory. The
+            // backend is settled in use_fanotify(), whose init() probes that
+            // marks are allowed, so fd() stays the same across add().
+            m_fanotify->add(root);
             return;
         }
-        std::error_code ec;
-        fs::directory_iterator iter { path, fs::directory_options::skip_permission_denied, ec };
-        fs::directory_iterator end {};
-        for (; !ec && iter != end; iter.increment(ec)) {
-            std::error_code file_status_ec;
-            if (fs::is_directory(m_follow_symlinks ? iter->status(file_status_ec) : iter->symlink_status(file_status_ec))) {
-                add(iter->path());
+#endif
+        auto node = add_watch(root, path_tree::npos, root);
+        if (node == path_tree::npos || !m_recursive) {
+            return;
+        }
+        add_subtree(node, root);
+    }
+
+    // watches every directory below the already watched node, level by level.
+    void watch::add_subtree(path_tree::node_id node, const std::string& path) {
+        std::vector<path_tree::node_id> level { node };
+        std::vector<std::string> dirs { path };
+        std::vector<std::vector<subdir>> found;
+        while (!level.empty()) {
+            scan_level(dirs, m_follow_symlinks, found);
+            std::vector<path_tree::node_id> next_level;
+            std::vector<std::string> next_dirs;
+            for (size_t i = 0; i < level.size(); ++i) {
+                for (auto& sub : found[i]) {
+                    std::string subpath = dirs[i] + "/" + sub.name;
+                    if (m_glob.excluded(subpath, true) || !m_filter(subpath.c_str())) {
+                        continue;
+                    }
+                    path_tree::node_id subnode;
+                    if (sub.symlink) {
+                        // a followed link lives elsewhere; keep it as its own root.
+                        std::error_code ec;
+                        subpath = fs::canonical(subpath, ec).string();
+                        if (ec) {
+                            continue;
+                        }
+                        subnode = add_watch(subpath, path_tree::npos, subpath);
+                    }
+                    else {
+                        subnode = add_watch(subpath, level[i], sub.name);
+                    }
+                    if (subnode != path_tree::npos) {
+                        next_level.push_back(subnode);
+                        next_dirs.push_back(std::move(subpath));
+                    }
+                }
             }
+            level.swap(next_level);
+            dirs.swap(next_dirs);
         }
     }
 
     void watch::set_recursive(bool enable) noexcept {
         m_recursive = enable;
+#if defined(__linux__)
+        if (m_fanotify) {
+            m_fanotify->set_recursive(enable);
+        }
+#endif
     }
 
     bool watch::set_follow_symlinks(bool enable) noexcept {
@@ -86,69 +258,195 @@ namespace bee::filewatch {
 
     bool watch::set_filter(filter f) {
         m_filter = f;
+#if defined(__linux__)
+        if (m_fanotify) {
+            m_fanotify->invalidate();
+        }
+#endif
+        return true;
+    }
+
+    bool watch::set_rules(const std::vector<std::string>& rules) {
+        m_glob.clear_rules();
+        for (auto& r : rules) {
+            m_glob.add_rule(r);
+        }
+#if defined(__linux__)
+        if (m_fanotify) {
+            m_fanotify->invalidate();
+        }
+#endif
+        return true;
+    }
+
+    bool watch::set_rescan(bool enable) {
+#if defined(__linux__)
+        if (m_fanotify) {
+            // a whole-filesystem listing is not worth keeping; overflow is reported instead.
+            return false;
+        }
+#endif
+        m_rescan = enable;
+        m_snapshot.clear();
+        if (enable) {
+            for (auto& [_, node] : m_wd_node) {
+                (void)_;
+                m_snapshot.record(m_tree.path(node));
+            }
+        }
         return true;
     }
 
+    void watch::rescan(uint64_t now) {
+        std::vector<std::string> dirs;
+        m_snapshot.rescan([&](notify_queue::event e, const std::string& path, bool dir) {
+            if (m_glob.excluded(path, dir)) {
+                return;
+            }
+            m_notify.push(e, path, now);
+            if (dir && e == notify_queue::event::created) {
+                dirs.push_back(path);
+            }
+        });
+        if (m_recursive) {
+            for (auto& dir : dirs) {
+                add(dir);
+            }
+        }
+    }
+
     void watch::update() {
         if (m_inotify_fd == -1) {
             return;
         }
-
-        struct pollfd pfd_read;
-        pfd_read.fd     = m_inotify_fd;
-        pfd_read.events = POLLIN;
-        if (poll(&pfd_read, 1, 0) != 1) {
+        // the fd is non-blocking, so read until it is drained instead of
+        // polling first; an empty queue costs a single EAGAIN.
+        uint64_t now = time_monotonic();
+#if defined(__linux__)
+        if (m_fanotify) {
+            if (!m_fanotify->read(m_notify, now, m_filter, m_glob)) {
+                m_notify.push_overflow();
+            }
+            m_notify.flush(now);
             return;
         }
+#endif
+        alignas(inotify_event) std::byte buf[16 * 1024];
+        for (;;) {
+            ssize_t n = read(m_inotify_fd, buf, sizeof buf);
+            if (n <= 0) {
+                break;
+            }
+            for (std::byte* p = buf; p < buf + n;) {
+                auto event = (struct inotify_event*)p;
+                event_update(event, now);
+                p += sizeof(*event) + event->len;
+            }
+        }
+        if (m_lost) {
+            m_lost = false;
+            if (m_rescan) {
+                rescan(now);
+            }
+            else {
+                m_notify.push_overflow();
+            }
+        }
+        m_notify.flush(now);
+    }
 
-        std::byte buf[4096];
-        ssize_t n = read(m_inotify_fd, buf, sizeof buf);
-        if (n == 0 || n == -1) {
-            return;
+    int watch::fd() const noexcept {
+#if defined(__linux__)
+        if (m_fanotify) {
+            return m_fanotify->fd();
         }
-        for (std::byte* p = buf; p < buf + n;) {
-            auto event = (struct inotify_event*)p;
-            event_update(event);
-            p += sizeof(*event) + event->len;
+#endif
+        return m_inotify_fd;
+    }
+
+    bool watch::wait(int timeout) {
+        if (m_inotify_fd == -1) {
+            return !m_notify.empty();
+        }
+        if (m_notify.empty()) {
+            // wake up in time to release paths whose quiet period ends first.
+            int64_t pending = m_notify.next_timeout(time_monotonic());
+            if (pending >= 0 && (timeout < 0 || pending < timeout)) {
+                timeout = (int)pending;
+            }
+            struct pollfd pfd_read;
+            pfd_read.fd     = fd();
+            pfd_read.events = POLLIN;
+            poll(&pfd_read, 1, timeout);
         }
+        update();
+        return !m_notify.empty();
     }
 
-    void watch::event_update(void* e) {
+    void watch::event_update(void* e, uint64_t now) {
         inotify_event* event = (inotify_event*)e;
         if (event->mask & IN_Q_OVERFLOW) {
-            // TODO?
+            // the kernel queue dropped events; recover once this batch is processed.
+            m_lost = true;
+            return;
         }
-
-        auto filename = m_fd_path[event->wd];
+        auto it = m_wd_node.find(event->wd);
+        if (it == m_wd_node.end()) {
+            return;
+        }
+        auto filename = m_tree.path(it->second);
         if (event->len > 1) {
+            if (m_rescan && (event->mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_CLOSE_WRITE | IN_MODIFY))) {
+                m_snapshot.refresh(filename, event->name);
+            }
             filename += "/";
             filename += std::string(event->name);
         }
-        if (event->mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)) {
-            m_notify.emplace(notify::flag::rename, filename);
-        }
-        else if (event->mask & (IN_MOVE_SELF | IN_ATTRIB | IN_CLOSE_WRITE | IN_MODIFY)) {
-            m_notify.emplace(notify::flag::modify, filename);
+        if (!m_glob.excluded(filename, event->mask & IN_ISDIR)) {
+            if (event->mask & IN_CREATE) {
+                m_notify.push(notify_queue::event::created, filename, now);
+            }
+            else if (event->mask & IN_DELETE) {
+                m_notify.push(notify_queue::event::removed, filename, now);
+            }
+            else if (event->mask & (IN_MOVED_FROM | IN_MOVED_TO)) {
+                m_notify.push(notify_queue::event::renamed, filename, now);
+            }
+            else if (event->mask & (IN_MOVE_SELF | IN_ATTRIB | IN_CLOSE_WRITE | IN_MODIFY)) {
+                m_notify.push(notify_queue::event::modified, filename, now);
+            }
         }
 
-        if (event->mask & (IN_IGNORED | IN_DELETE_SELF)) {
-            m_fd_path.erase(event->wd);
-        }
-        if (event->mask & IN_MOVE_SELF) {
-            inotify_rm_watch(m_inotify_fd, event->wd);
-            m_fd_path.erase(event->wd);
+        if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+            if (event->mask & IN_MOVE_SELF) {
+                inotify_rm_watch(m_inotify_fd, event->wd);
+            }
+            m_snapshot.forget(filename);
+            m_tree.erase(it->second);
+            m_wd_node.erase(it);
+            return;
         }
         if (m_recursive && (event->mask & IN_ISDIR) && (event->mask & IN_CREATE)) {
-            add(filename);
+            if (m_glob.excluded(filename, true) || !m_filter(filename.c_str())) {
+                return;
+            }
+            // hang the new directory under its parent instead of making it a root.
+            auto node = add_watch(filename, it->second, event->name);
+            if (node != path_tree::npos) {
+                add_subtree(node, filename);
+            }
         }
     }
 
+    void watch::set_quiet_period(uint64_t ms, uint64_t max_ms) {
+        m_notify.set_quiet_period(ms, max_ms);
+    }
+
+    void watch::set_queue_limit(size_t limit) {
+        m_notify.set_limit(limit);
+    }
+
     std::optional<notify> watch::select() {
-        if (m_notify.empty()) {
-            return std::nullopt;
-        }
-        auto n = m_notify.front();
-        m_notify.pop();
-        return n;
+        return m_notify.pop();
     }
 }
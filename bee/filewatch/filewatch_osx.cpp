@@ -1,11 +1,22 @@
 #include <bee/filewatch/filewatch.h>
 #include <bee/nonstd/unreachable.h>
+#include <bee/time/monotonic.h>
+
+#include <chrono>
 
 namespace bee::filewatch {
     const char* watch::type() noexcept {
         return "fsevent";
     }
 
+    const char* watch::backend() const noexcept {
+        return type();
+    }
+
+    bool watch::use_fanotify() {
+        return false;
+    }
+
     static void event_cb(ConstFSEventStreamRef streamRef, void* info, size_t numEvents, void* eventPaths, const FSEventStreamEventFlags eventFlags[], const FSEventStreamEventId eventIds[]) {
         (void)streamRef;
         (void)eventIds;
@@ -23,6 +34,8 @@ namespace bee::filewatch {
     void watch::stop() noexcept {
         destroy_stream();
         m_paths.clear();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_glob.clear_roots();
     }
 
     bool watch::create_stream(CFArrayRef cf_paths) noexcept {
@@ -66,6 +79,10 @@ namespace bee::filewatch {
     }
 
     void watch::add(const string_type& path) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_glob.add_root(path);
+        }
         m_paths.emplace(path);
         update_stream();
     }
@@ -82,6 +99,15 @@ namespace bee::filewatch {
         return false;
     }
 
+    bool watch::set_rules(const std::vector<std::string>& rules) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_glob.clear_rules();
+        for (auto& r : rules) {
+            m_glob.add_rule(r);
+        }
+        return true;
+    }
+
     void watch::update_stream() {
         destroy_stream();
         if (m_paths.empty()) {
@@ -109,29 +135,78 @@ namespace bee::filewatch {
     void watch::update() {
     }
 
+    int watch::fd() const noexcept {
+        return -1;
+    }
+
+    bool watch::wait(int timeout) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notify.flush(time_monotonic());
+        if (m_notify.empty()) {
+            int64_t pending = m_notify.next_timeout(time_monotonic());
+            if (pending >= 0 && (timeout < 0 || pending < timeout)) {
+                timeout = (int)pending;
+            }
+            if (timeout < 0) {
+                m_cond.wait(lock);
+            }
+            else {
+                m_cond.wait_for(lock, std::chrono::milliseconds(timeout));
+            }
+            m_notify.flush(time_monotonic());
+        }
+        return !m_notify.empty();
+    }
+
     void watch::event_update(const char* paths[], const FSEventStreamEventFlags flags[], size_t n) {
         std::unique_lock<std::mutex> lock(m_mutex);
+        uint64_t now = time_monotonic();
         for (size_t i = 0; i < n; ++i) {
             const char* path = paths[i];
             if (!m_recursive && path[0] != '\0' && strchr(path + 1, '/') != NULL) {
                 continue;
             }
-            if (flags[i] & (kFSEventStreamEventFlagItemCreated | kFSEventStreamEventFlagItemRemoved | kFSEventStreamEventFlagItemRenamed)) {
-                m_notify.emplace(notify::flag::rename, path);
+            if (flags[i] & (kFSEventStreamEventFlagMustScanSubDirs | kFSEventStreamEventFlagUserDropped | kFSEventStreamEventFlagKernelDropped)) {
+                m_notify.push_overflow();
+                continue;
+            }
+            if (m_glob.excluded(path, flags[i] & kFSEventStreamEventFlagItemIsDir)) {
+                continue;
+            }
+            if (flags[i] & kFSEventStreamEventFlagItemRemoved) {
+                m_notify.push(notify_queue::event::removed, path, now);
+            }
+            else if (flags[i] & kFSEventStreamEventFlagItemCreated) {
+                m_notify.push(notify_queue::event::created, path, now);
+            }
+            else if (flags[i] & kFSEventStreamEventFlagItemRenamed) {
+                m_notify.push(notify_queue::event::renamed, path, now);
             }
             else if (flags[i] & (kFSEventStreamEventFlagItemFinderInfoMod | kFSEventStreamEventFlagItemModified | kFSEventStreamEventFlagItemInodeMetaMod | kFSEventStreamEventFlagItemChangeOwner | kFSEventStreamEventFlagItemXattrMod)) {
-                m_notify.emplace(notify::flag::modify, path);
+                m_notify.push(notify_queue::event::modified, path, now);
             }
         }
+        m_notify.flush(now);
+        m_cond.notify_all();
+    }
+
+    bool watch::set_rescan(bool enable) {
+        return false;
+    }
+
+    void watch::set_quiet_period(uint64_t ms, uint64_t max_ms) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notify.set_quiet_period(ms, max_ms);
+    }
+
+    void watch::set_queue_limit(size_t limit) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notify.set_limit(limit);
     }
 
     std::optional<notify> watch::select() {
         std::unique_lock<std::mutex> lock(m_mutex);
-        if (m_notify.empty()) {
-            return std::nullopt;
-        }
-        auto n = m_notify.front();
-        m_notify.pop();
-        return n;
+        m_notify.flush(time_monotonic());
+        return m_notify.pop();
     }
 }
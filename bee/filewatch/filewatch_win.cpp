@@ -3,6 +3,7 @@
 #include <bee/filewatch/filewatch.h>
 #include <bee/nonstd/unreachable.h>
 #include <bee/platform/win/unicode.h>
+#include <bee/time/monotonic.h>
 
 #include <array>
 #include <cassert>
@@ -12,6 +13,14 @@ namespace bee::filewatch {
         return "windows";
     }
 
+    const char* watch::backend() const noexcept {
+        return type();
+    }
+
+    bool watch::use_fanotify() {
+        return false;
+    }
+
     class task : public OVERLAPPED {
         static const size_t kBufSize = 16 * 1024;
 
@@ -107,7 +116,6 @@ namespace bee::filewatch {
         }
         if (dwErrorCode != 0) {
             if (dwErrorCode == ERROR_NOTIFY_ENUM_DIR) {
-                // TODO notify overflow
                 return result::zero;
             }
             cancel();
@@ -145,12 +153,14 @@ namespace bee::filewatch {
             task.cancel();
         }
         m_tasks.clear();
+        m_glob.clear_roots();
     }
 
     void watch::add(const string_type& path) {
         auto& t = m_tasks.emplace_back();
         if (t.open(path)) {
             if (t.start(m_recursive)) {
+                m_glob.add_root(win::w2u(path));
                 return;
             }
         }
@@ -169,7 +179,15 @@ namespace bee::filewatch {
         return false;
     }
 
-    bool watch::event_update(task& task) {
+    bool watch::set_rules(const std::vector<std::string>& rules) {
+        m_glob.clear_rules();
+        for (auto& r : rules) {
+            m_glob.add_rule(r);
+        }
+        return true;
+    }
+
+    bool watch::event_update(task& task, uint64_t now) {
         switch (task.try_read()) {
         case task::result::wait:
             return true;
@@ -177,6 +195,8 @@ namespace bee::filewatch {
             task.cancel();
             return false;
         case task::result::zero:
+            // the change buffer overflowed and its contents were discarded.
+            m_notify.push_overflow();
             return task.start(m_recursive);
         case task::result::success:
             break;
@@ -185,20 +205,27 @@ namespace bee::filewatch {
         for (;;) {
             const FILE_NOTIFY_INFORMATION& fni = (const FILE_NOTIFY_INFORMATION&)*data;
             std::wstring path(fni.FileName, fni.FileNameLength / sizeof(wchar_t));
-            path = task.path() + L"/" + path;
-            switch (fni.Action) {
-            case FILE_ACTION_MODIFIED:
-                m_notify.emplace(notify::flag::modify, win::w2u(path));
-                break;
-            case FILE_ACTION_ADDED:
-            case FILE_ACTION_REMOVED:
-            case FILE_ACTION_RENAMED_OLD_NAME:
-            case FILE_ACTION_RENAMED_NEW_NAME:
-                m_notify.emplace(notify::flag::rename, win::w2u(path));
-                break;
-            default:
-                std::unreachable();
-                break;
+            path              = task.path() + L"/" + path;
+            std::string u8path = win::w2u(path);
+            if (!m_glob.excluded(u8path, false)) {
+                switch (fni.Action) {
+                case FILE_ACTION_MODIFIED:
+                    m_notify.push(notify_queue::event::modified, u8path, now);
+                    break;
+                case FILE_ACTION_ADDED:
+                    m_notify.push(notify_queue::event::created, u8path, now);
+                    break;
+                case FILE_ACTION_REMOVED:
+                    m_notify.push(notify_queue::event::removed, u8path, now);
+                    break;
+                case FILE_ACTION_RENAMED_OLD_NAME:
+                case FILE_ACTION_RENAMED_NEW_NAME:
+                    m_notify.push(notify_queue::event::renamed, u8path, now);
+                    break;
+                default:
+                    std::unreachable();
+                    break;
+                }
             }
             if (!fni.NextEntryOffset) {
                 break;
@@ -209,22 +236,60 @@ namespace bee::filewatch {
     }
 
     void watch::update() {
+        uint64_t now = time_monotonic();
         for (auto iter = m_tasks.begin(); iter != m_tasks.end();) {
-            if (event_update(*iter)) {
+            if (event_update(*iter, now)) {
                 ++iter;
             }
             else {
                 iter = m_tasks.erase(iter);
             }
         }
+        m_notify.flush(now);
     }
 
-    std::optional<notify> watch::select() {
-        if (m_notify.empty()) {
-            return std::nullopt;
+    int watch::fd() const noexcept {
+        return -1;
+    }
+
+    bool watch::wait(int timeout) {
+        if (m_notify.empty() && !m_tasks.empty()) {
+            HANDLE handles[MAXIMUM_WAIT_OBJECTS];
+            DWORD n = 0;
+            for (auto& task : m_tasks) {
+                if (n == MAXIMUM_WAIT_OBJECTS) {
+                    break;
+                }
+                handles[n++] = task.hEvent;
+            }
+            int64_t pending = m_notify.next_timeout(time_monotonic());
+            if (pending >= 0 && (timeout < 0 || pending < timeout)) {
+                timeout = (int)pending;
+            }
+            // directories past the wait limit cannot wake us, so only nap briefly.
+            DWORD ms = timeout < 0 ? INFINITE : (DWORD)timeout;
+            if (m_tasks.size() > MAXIMUM_WAIT_OBJECTS && (ms == INFINITE || ms > 10)) {
+                ms = 10;
+            }
+            ::WaitForMultipleObjects(n, handles, FALSE, ms);
         }
-        auto n = m_notify.front();
-        m_notify.pop();
-        return n;
+        update();
+        return !m_notify.empty();
+    }
+
+    bool watch::set_rescan(bool enable) {
+        return false;
+    }
+
+    void watch::set_quiet_period(uint64_t ms, uint64_t max_ms) {
+        m_notify.set_quiet_period(ms, max_ms);
+    }
+
+    void watch::set_queue_limit(size_t limit) {
+        m_notify.set_limit(limit);
+    }
+
+    std::optional<notify> watch::select() {
+        return m_notify.pop();
     }
 }
@@ -0,0 +1,221 @@
+#include <bee/filewatch/glob_filter.h>
+
+namespace bee::filewatch {
+    // matches c against the bracket expression at the start of p: returns 1
+    // or 0 and sets len to its length, or -1 when it is unterminated and
+    // the "[" is literal.
+    static int match_class(std::string_view p, char c, size_t& len) {
+        size_t i    = 1;
+        bool negate = false;
+        if (i < p.size() && (p[i] == '!' || p[i] == '^')) {
+            negate = true;
+            ++i;
+        }
+        bool found   = false;
+        size_t first = i;
+        for (; i < p.size(); ++i) {
+            if (p[i] == ']' && i != first) {
+                len = i + 1;
+                return found != negate ? 1 : 0;
+            }
+            char lo = p[i];
+            if (lo == '\\' && i + 1 < p.size()) {
+                lo = p[++i];
+            }
+            char hi = lo;
+            if (i + 2 < p.size() && p[i + 1] == '-' && p[i + 2] != ']') {
+                hi = p[i + 2];
+                i += 2;
+            }
+            if (lo <= c && c <= hi) {
+                found = true;
+            }
+        }
+        return -1;
+    }
+
+    static bool glob_match(std::string_view p, std::string_view s) {
+        while (!p.empty()) {
+            char c = p[0];
+            if (c == '*') {
+                if (p.size() >= 2 && p[1] == '*') {
+                    p.remove_prefix(2);
+                    if (p.empty()) {
+                        return true;
+                    }
+                    if (p[0] == '/') {
+                        // "**/" spans zero or more whole directories.
+                        p.remove_prefix(1);
+                        for (;;) {
+                            if (glob_match(p, s)) {
+                                return true;
+                            }
+                            size_t slash = s.find('/');
+                            if (slash == std::string_view::npos) {
+                                return false;
+                            }
+                            s.remove_prefix(slash + 1);
+                        }
+                    }
+                }
+                else {
+                    p.remove_prefix(1);
+                }
+                for (size_t i = 0;; ++i) {
+                    if (glob_match(p, s.substr(i))) {
+                        return true;
+                    }
+                    if (i >= s.size() || s[i] == '/') {
+                        return false;
+                    }
+                }
+            }
+            if (s.empty()) {
+                return false;
+            }
+            size_t len = 1;
+            int m;
+            if (c == '?') {
+                if (s[0] == '/') {
+                    return false;
+                }
+            }
+            else if (c == '[' && (m = match_class(p, s[0], len)) >= 0) {
+                if (m == 0 || s[0] == '/') {
+                    return false;
+                }
+            }
+            else {
+                len = 1;
+                if (c == '\\' && p.size() > 1) {
+                    c   = p[1];
+                    len = 2;
+                }
+                if (c != s[0]) {
+                    return false;
+                }
+            }
+            p.remove_prefix(len);
+            s.remove_prefix(1);
+        }
+        return s.empty();
+    }
+
+    void glob_filter::add_rule(std::string_view line) {
+        while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) {
+            line.remove_suffix(1);
+        }
+        while (!line.empty() && line.back() == ' ' && !(line.size() >= 2 && line[line.size() - 2] == '\\')) {
+            line.remove_suffix(1);
+        }
+        if (line.empty() || line[0] == '#') {
+            return;
+        }
+        rule r;
+        r.negate = line[0] == '!';
+        if (r.negate) {
+            line.remove_prefix(1);
+        }
+        r.dir_only = !line.empty() && line.back() == '/';
+        if (r.dir_only) {
+            line.remove_suffix(1);
+        }
+        r.anchored = line.find('/') != std::string_view::npos;
+        if (!line.empty() && line[0] == '/') {
+            line.remove_prefix(1);
+        }
+        if (line.empty()) {
+            return;
+        }
+        r.pattern.assign(line.data(), line.size());
+        m_rules.emplace_back(std::move(r));
+    }
+
+    void glob_filter::clear_rules() noexcept {
+        m_rules.clear();
+    }
+
+    void glob_filter::add_root(const std::string& path) {
+        std::string root = path;
+#if defined(_WIN32)
+        for (auto& c : root) {
+            if (c == '\\') {
+                c = '/';
+            }
+        }
+#endif
+        for (auto& r : m_roots) {
+            if (root.size() >= r.size() && root.compare(0, r.size(), r) == 0 && (root.size() == r.size() || r.back() == '/' || root[r.size()] == '/')) {
+                // directories added while following the tree keep the outer root.
+                return;
+            }
+        }
+        m_roots.push_back(std::move(root));
+    }
+
+    void glob_filter::clear_roots() noexcept {
+        m_roots.clear();
+    }
+
+    bool glob_filter::empty() const noexcept {
+        return m_rules.empty();
+    }
+
+    bool glob_filter::decide(std::string_view rel, bool dir, bool& exclude) const {
+        std::string_view name = rel;
+        size_t slash          = rel.rfind('/');
+        if (slash != std::string_view::npos) {
+            name = rel.substr(slash + 1);
+        }
+        for (auto it = m_rules.rbegin(); it != m_rules.rend(); ++it) {
+            if (it->dir_only && !dir) {
+                continue;
+            }
+            if (glob_match(it->pattern, it->anchored ? rel : name)) {
+                exclude = !it->negate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool glob_filter::excluded_relative(std::string_view rel, bool dir) const {
+        bool exclude = false;
+        for (size_t pos = rel.find('/'); pos != std::string_view::npos; pos = rel.find('/', pos + 1)) {
+            if (decide(rel.substr(0, pos), true, exclude) && exclude) {
+                return true;
+            }
+        }
+        return decide(rel, dir, exclude) && exclude;
+    }
+
+    bool glob_filter::excluded(std::string_view path, bool dir) const {
+        if (m_rules.empty()) {
+            return false;
+        }
+#if defined(_WIN32)
+        std::string copy(path);
+        for (auto& c : copy) {
+            if (c == '\\') {
+                c = '/';
+            }
+        }
+        path = copy;
+#endif
+        for (auto& root : m_roots) {
+            if (path.size() <= root.size() || path.compare(0, root.size(), root) != 0) {
+                continue;
+            }
+            std::string_view rel = path.substr(root.size());
+            if (root.back() != '/' && rel[0] != '/') {
+                continue;
+            }
+            // the backends may join a root ending in '/' with another one.
+            while (!rel.empty() && rel[0] == '/') {
+                rel.remove_prefix(1);
+            }
+            return !rel.empty() && excluded_relative(rel, dir);
+        }
+        return false;
+    }
+}
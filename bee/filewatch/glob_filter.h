@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bee::filewatch {
+    // Compiled gitignore-style rules evaluated natively, so neither tree
+    // registration nor event delivery has to call back into Lua. Rules are
+    // matched against paths relative to the outermost watched root; the
+    // last matching rule wins, "!" re-includes, a trailing "/" restricts a
+    // rule to directories, a rule containing "/" is anchored to the root
+    // and one without matches the name at any depth. "*", "?", "[...]" and
+    // "**" behave as in .gitignore, and nothing below an excluded
+    // directory can be re-included.
+    class glob_filter {
+    public:
+        void add_rule(std::string_view line);
+        void clear_rules() noexcept;
+        void add_root(const std::string& path);
+        void clear_roots() noexcept;
+        bool empty() const noexcept;
+        // path is absolute; paths outside every root are never excluded.
+        bool excluded(std::string_view path, bool dir) const;
+
+    private:
+        struct rule {
+            std::string pattern;
+            bool negate;
+            bool dir_only;
+            bool anchored;
+        };
+        bool excluded_relative(std::string_view rel, bool dir) const;
+        bool decide(std::string_view rel, bool dir, bool& exclude) const;
+
+        std::vector<rule> m_rules;
+        std::vector<std::string> m_roots;
+    };
+}
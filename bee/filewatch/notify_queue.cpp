@@ -0,0 +1,120 @@
+#include <bee/filewatch/notify_queue.h>
+
+#include <algorithm>
+
+namespace bee::filewatch {
+    static notify_queue::event merge(notify_queue::event prev, notify_queue::event next) noexcept {
+        using event = notify_queue::event;
+        if (next == event::modified) {
+            return prev;
+        }
+        if (prev == event::removed && next == event::created) {
+            return event::renamed;
+        }
+        return next;
+    }
+
+    static notify::flag to_flag(notify_queue::event e) noexcept {
+        return e == notify_queue::event::modified ? notify::flag::modify : notify::flag::rename;
+    }
+
+    void notify_queue::set_quiet_period(uint64_t ms, uint64_t max_ms) noexcept {
+        m_quiet   = ms;
+        m_maxwait = (std::max)(ms, max_ms);
+    }
+
+    uint64_t notify_queue::deadline(uint64_t first, uint64_t now) const noexcept {
+        return (std::min)(now + m_quiet, first + m_maxwait);
+    }
+
+    void notify_queue::set_limit(size_t limit) noexcept {
+        m_limit = limit;
+    }
+
+    size_t notify_queue::size() const noexcept {
+        return m_pending.size() + m_ready.size();
+    }
+
+    void notify_queue::push(event e, const std::string& path, uint64_t now) {
+        if (m_overflow) {
+            return;
+        }
+        auto it = m_index.find(path);
+        if (it != m_index.end()) {
+            auto& p = *it->second;
+            if (p.kind == event::created && e == event::removed) {
+                m_pending.erase(it->second);
+                m_index.erase(it);
+                return;
+            }
+            // pushing the deadline back only ever raises it, so m_next stays a lower bound.
+            p.kind     = merge(p.kind, e);
+            p.deadline = deadline(p.first, now);
+            return;
+        }
+        if (m_limit != 0 && size() >= m_limit) {
+            push_overflow();
+            return;
+        }
+        m_pending.push_back({ path, e, now, deadline(now, now) });
+        m_index.emplace(path, std::prev(m_pending.end()));
+        m_next = (std::min)(m_next, m_pending.back().deadline);
+    }
+
+    void notify_queue::push_overflow() {
+        if (m_overflow) {
+            return;
+        }
+        clear();
+        m_ready.emplace_back(notify::flag::overflow, std::string {});
+        m_overflow = true;
+    }
+
+    void notify_queue::flush(uint64_t now) {
+        if (now < m_next) {
+            return;
+        }
+        m_next = UINT64_MAX;
+        for (auto it = m_pending.begin(); it != m_pending.end();) {
+            if (it->deadline > now) {
+                m_next = (std::min)(m_next, it->deadline);
+                ++it;
+                continue;
+            }
+            m_index.erase(it->path);
+            m_ready.emplace_back(to_flag(it->kind), std::move(it->path));
+            it = m_pending.erase(it);
+        }
+    }
+
+    std::optional<notify> notify_queue::pop() {
+        if (m_ready.empty()) {
+            return std::nullopt;
+        }
+        auto n = std::move(m_ready.front());
+        m_ready.pop_front();
+        if (n.flags == notify::flag::overflow) {
+            m_overflow = false;
+        }
+        return n;
+    }
+
+    bool notify_queue::empty() const noexcept {
+        return m_ready.empty();
+    }
+
+    int64_t notify_queue::next_timeout(uint64_t now) const noexcept {
+        if (m_next == UINT64_MAX) {
+            return -1;
+        }
+        return m_next <= now ? 0 : (int64_t)(m_next - now);
+    }
+
+    void notify_queue::clear() noexcept {
+        m_pending.clear();
+        m_index.clear();
+        m_ready.clear();
+        m_next     = UINT64_MAX;
+        m_overflow = false;
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace bee::filewatch {
+    struct notify {
+        enum class flag {
+            modify,
+            rename,
+            overflow,
+        };
+        flag flags;
+        std::string path;
+        notify(const flag& flags, const std::string& path)
+            : flags(flags)
+            , path(path) {}
+    };
+
+    // Coalesces raw backend events before they reach the consumer. Events
+    // for the same path merge while the path stays busy; a path is released
+    // once it has been quiet for the configured period, or once the maximum
+    // wait since its first event has passed, so a path written more often
+    // than the quiet period is still reported. A file created and
+    // removed inside that window is dropped entirely. When more than limit
+    // paths are queued the queue is replaced by one overflow notification
+    // and further events are ignored until it has been consumed.
+    class notify_queue {
+    public:
+        enum class event {
+            created,
+            removed,
+            modified,
+            renamed,
+        };
+
+        void set_quiet_period(uint64_t ms, uint64_t max_ms) noexcept;
+        void set_limit(size_t limit) noexcept;
+        void push(event e, const std::string& path, uint64_t now);
+        void push_overflow();
+        // moves every path that has been quiet long enough to the ready list.
+        void flush(uint64_t now);
+        std::optional<notify> pop();
+        bool empty() const noexcept;
+        // milliseconds until the next pending path is released, or -1.
+        int64_t next_timeout(uint64_t now) const noexcept;
+        void clear() noexcept;
+
+    private:
+        struct pending {
+            std::string path;
+            event kind;
+            uint64_t first;
+            uint64_t deadline;
+        };
+        uint64_t deadline(uint64_t first, uint64_t now) const noexcept;
+        size_t size() const noexcept;
+
+        std::list<pending> m_pending;
+        std::unordered_map<std::string, std::list<pending>::iterator> m_index;
+        std::deque<notify> m_ready;
+        uint64_t m_quiet   = 0;
+        uint64_t m_maxwait = 0;
+        uint64_t m_next    = UINT64_MAX;
+        size_t m_limit     = 0;
+        bool m_overflow    = false;
+    };
+}
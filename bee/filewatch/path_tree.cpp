@@ -0,0 +1,101 @@
+#include <bee/filewatch/path_tree.h>
+
+namespace bee::filewatch {
+    static constexpr size_t kCompactThreshold = 64 * 1024;
+
+    path_tree::node_id path_tree::insert(node_id parent, std::string_view name) {
+        node_id id;
+        if (m_free.empty()) {
+            id = (node_id)m_nodes.size();
+            m_nodes.emplace_back();
+        }
+        else {
+            id = m_free.back();
+            m_free.pop_back();
+        }
+        auto& n    = m_nodes[id];
+        n.parent   = parent;
+        n.name_off = (uint32_t)m_names.size();
+        n.name_len = (uint32_t)name.size();
+        n.nchild   = 0;
+        n.live     = true;
+        m_names.append(name.data(), name.size());
+        if (parent != npos) {
+            m_nodes[parent].nchild++;
+        }
+        m_size++;
+        return id;
+    }
+
+    void path_tree::erase(node_id id) noexcept {
+        if (id >= m_nodes.size() || !m_nodes[id].live) {
+            return;
+        }
+        m_nodes[id].live = false;
+        m_size--;
+        // free the node and every dead ancestor that has just lost its last child.
+        while (id != npos) {
+            auto& n = m_nodes[id];
+            if (n.live || n.nchild != 0) {
+                break;
+            }
+            node_id parent = n.parent;
+            m_garbage += n.name_len;
+            n.name_len = 0;
+            n.parent   = npos;
+            m_free.push_back(id);
+            if (parent != npos) {
+                m_nodes[parent].nchild--;
+            }
+            id = parent;
+        }
+        if (m_garbage > kCompactThreshold && m_garbage > m_names.size() / 2) {
+            compact();
+        }
+    }
+
+    std::string path_tree::path(node_id id) const {
+        size_t len = 0;
+        for (node_id i = id; i != npos; i = m_nodes[i].parent) {
+            len += m_nodes[i].name_len + 1;
+        }
+        std::string r(len - 1, '/');
+        size_t pos = r.size();
+        for (node_id i = id; i != npos; i = m_nodes[i].parent) {
+            auto& n = m_nodes[i];
+            pos -= n.name_len;
+            r.replace(pos, n.name_len, m_names, n.name_off, n.name_len);
+            if (pos > 0) {
+                --pos;
+            }
+        }
+        return r;
+    }
+
+    void path_tree::compact() {
+        std::string names;
+        names.reserve(m_names.size() - m_garbage);
+        for (auto& n : m_nodes) {
+            if (n.name_len == 0) {
+                continue;
+            }
+            uint32_t off = (uint32_t)names.size();
+            names.append(m_names, n.name_off, n.name_len);
+            n.name_off = off;
+        }
+        m_names.swap(names);
+        m_garbage = 0;
+    }
+
+    void path_tree::clear() noexcept {
+        m_nodes.clear();
+        m_free.clear();
+        m_names.clear();
+        m_garbage = 0;
+        m_size    = 0;
+    }
+
+    size_t path_tree::size() const noexcept {
+        return m_size;
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bee::filewatch {
+    // Directory paths stored as parent pointers plus one shared name arena,
+    // so a watched directory costs a 20-byte node and its own name instead
+    // of a full path string. Nodes stay alive while they still have
+    // children, which keeps descendants resolvable until they are erased.
+    class path_tree {
+    public:
+        using node_id                 = uint32_t;
+        static constexpr node_id npos = (node_id)-1;
+
+        // parent == npos makes name an absolute root.
+        node_id insert(node_id parent, std::string_view name);
+        void erase(node_id id) noexcept;
+        std::string path(node_id id) const;
+        void clear() noexcept;
+        size_t size() const noexcept;
+
+    private:
+        struct node {
+            node_id parent;
+            uint32_t name_off;
+            uint32_t name_len;
+            uint32_t nchild;
+            bool live;
+        };
+        void compact();
+
+        std::vector<node> m_nodes;
+        std::vector<node_id> m_free;
+        std::string m_names;
+        size_t m_garbage = 0;
+        size_t m_size    = 0;
+    };
+}
@@ -0,0 +1,107 @@
+#include <bee/filewatch/snapshot.h>
+#include <bee/nonstd/filesystem.h>
+
+#include <vector>
+
+namespace bee::filewatch {
+    template <typename Entry>
+    static bool read_entry(const Entry& e, int64_t& mtime, uint64_t& size, bool& dir) {
+        std::error_code ec;
+        auto st = e.symlink_status(ec);
+        if (ec || !fs::exists(st)) {
+            return false;
+        }
+        dir   = fs::is_directory(st);
+        size  = 0;
+        mtime = 0;
+        if (!dir) {
+            // directory mtimes change with every entry; their children are compared instead.
+            if (fs::is_regular_file(st)) {
+                size = e.file_size(ec);
+            }
+            mtime = e.last_write_time(ec).time_since_epoch().count();
+        }
+        return true;
+    }
+
+    void snapshot::list(const std::string& dir, listing& out) {
+        std::error_code ec;
+        fs::directory_iterator iter { fs::path(dir), fs::directory_options::skip_permission_denied, ec };
+        fs::directory_iterator end {};
+        for (; !ec && iter != end; iter.increment(ec)) {
+            entry e;
+            if (read_entry(*iter, e.mtime, e.size, e.dir)) {
+                out.emplace(iter->path().filename().string(), e);
+            }
+        }
+    }
+
+    void snapshot::record(const std::string& dir) {
+        auto& l = m_dirs[dir];
+        l.clear();
+        list(dir, l);
+    }
+
+    void snapshot::forget(const std::string& dir) noexcept {
+        m_dirs.erase(dir);
+    }
+
+    void snapshot::refresh(const std::string& dir, const std::string& name) {
+        auto it = m_dirs.find(dir);
+        if (it == m_dirs.end()) {
+            return;
+        }
+        fs::directory_entry de { fs::path(dir) / name };
+        entry e;
+        if (read_entry(de, e.mtime, e.size, e.dir)) {
+            it->second[name] = e;
+        }
+        else {
+            it->second.erase(name);
+        }
+    }
+
+    void snapshot::rescan(const emit_fn& emit) {
+        std::vector<std::string> gone;
+        for (auto& [dir, old] : m_dirs) {
+            listing now;
+            list(dir, now);
+            if (now.empty()) {
+                std::error_code ec;
+                if (!fs::is_directory(fs::path(dir), ec)) {
+                    gone.push_back(dir);
+                    continue;
+                }
+            }
+            // both listings are sorted by name, so one merge pass finds every difference.
+            auto a = old.begin();
+            auto b = now.begin();
+            while (a != old.end() || b != now.end()) {
+                if (b == now.end() || (a != old.end() && a->first < b->first)) {
+                    emit(notify_queue::event::removed, dir + "/" + a->first, a->second.dir);
+                    ++a;
+                }
+                else if (a == old.end() || b->first < a->first) {
+                    emit(notify_queue::event::created, dir + "/" + b->first, b->second.dir);
+                    ++b;
+                }
+                else {
+                    if (!(a->second == b->second)) {
+                        bool dir_changed = a->second.dir != b->second.dir;
+                        emit(dir_changed ? notify_queue::event::renamed : notify_queue::event::modified, dir + "/" + b->first, b->second.dir);
+                    }
+                    ++a;
+                    ++b;
+                }
+            }
+            old.swap(now);
+        }
+        for (auto& dir : gone) {
+            m_dirs.erase(dir);
+        }
+    }
+
+    void snapshot::clear() noexcept {
+        m_dirs.clear();
+    }
+}
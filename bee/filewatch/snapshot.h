@@ -0,0 +1,40 @@
+#pragma once
+
+#include <bee/filewatch/notify_queue.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+namespace bee::filewatch {
+    // Per-directory listing of (name, mtime, size) used to recover from a
+    // lost event stream: rescan() relists every recorded directory and
+    // reports only what differs from the last known state.
+    class snapshot {
+    public:
+        using emit_fn = std::function<void(notify_queue::event e, const std::string& path, bool dir)>;
+
+        void record(const std::string& dir);
+        void forget(const std::string& dir) noexcept;
+        // re-reads one entry after a live event so the next rescan stays quiet about it.
+        void refresh(const std::string& dir, const std::string& name);
+        void rescan(const emit_fn& emit);
+        void clear() noexcept;
+
+    private:
+        struct entry {
+            int64_t mtime;
+            uint64_t size;
+            bool dir;
+            bool operator==(const entry& o) const noexcept {
+                return mtime == o.mtime && size == o.size && dir == o.dir;
+            }
+        };
+        using listing = std::map<std::string, entry>;
+        static void list(const std::string& dir, listing& out);
+
+        std::unordered_map<std::string, listing> m_dirs;
+    };
+}
@@ -0,0 +1,232 @@
+#include <bee/net/conntable.h>
+
+#if defined(_WIN32)
+#    include <winsock2.h>
+#else
+#    include <errno.h>
+#    include <poll.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <thread>
+
+namespace bee::net {
+#if defined(_WIN32)
+    using pollfd_t = WSAPOLLFD;
+#else
+    using pollfd_t = struct pollfd;
+#endif
+
+    static constexpr size_t kReadSize = 64 * 1024;
+
+    static uint32_t id_index(conntable::conn_id id) noexcept {
+        return (uint32_t)id;
+    }
+
+    static uint32_t id_gen(conntable::conn_id id) noexcept {
+        return (uint32_t)(id >> 32);
+    }
+
+    conntable::conntable(size_t nslots)
+        : m_nslots(nslots) {}
+
+    conntable::~conntable() noexcept {
+        clear();
+    }
+
+    conntable::conn_id conntable::add(fd_t fd) {
+        uint32_t index;
+        if (m_free.empty()) {
+            index = (uint32_t)m_conns.size();
+            m_conns.emplace_back();
+            m_slots.resize(m_slots.size() + m_nslots);
+        }
+        else {
+            index = m_free.back();
+            m_free.pop_back();
+        }
+        auto& c = m_conns[index];
+        c.fd    = fd;
+        c.poll  = (uint32_t)m_polls.size();
+        m_polls.push_back({ fd, 0, 0 });
+        m_pollowner.push_back(index);
+        return ((conn_id)c.gen << 32) | index;
+    }
+
+    conntable::conn* conntable::find(conn_id id) noexcept {
+        uint32_t index = id_index(id);
+        if (index >= m_conns.size()) {
+            return nullptr;
+        }
+        auto& c = m_conns[index];
+        if (c.fd == retired_fd || c.gen != id_gen(id)) {
+            return nullptr;
+        }
+        return &c;
+    }
+
+    void conntable::release(uint32_t index) noexcept {
+        auto& c = m_conns[index];
+        // keep the poll array dense: the last slot takes the freed position.
+        uint32_t last = (uint32_t)m_polls.size() - 1;
+        if (c.poll != last) {
+            m_polls[c.poll]                 = m_polls[last];
+            m_pollowner[c.poll]             = m_pollowner[last];
+            m_conns[m_pollowner[last]].poll = c.poll;
+        }
+        m_polls.pop_back();
+        m_pollowner.pop_back();
+        c.fd = retired_fd;
+        c.gen++;
+        c.in  = bytebuffer {};
+        c.out = bytebuffer {};
+        std::fill_n(m_slots.begin() + index * m_nslots, m_nslots, 0);
+        m_free.push_back(index);
+    }
+
+    fd_t conntable::detach(conn_id id) noexcept {
+        auto c = find(id);
+        if (!c) {
+            return retired_fd;
+        }
+        fd_t fd = c->fd;
+        release(id_index(id));
+        return fd;
+    }
+
+    bool conntable::close(conn_id id) noexcept {
+        fd_t fd = detach(id);
+        if (fd == retired_fd) {
+            return false;
+        }
+        socket::close(fd);
+        return true;
+    }
+
+    void conntable::clear() noexcept {
+        for (uint32_t index = 0; index < m_conns.size(); ++index) {
+            auto& c = m_conns[index];
+            if (c.fd != retired_fd) {
+                socket::close(c.fd);
+                release(index);
+            }
+        }
+    }
+
+    size_t conntable::size() const noexcept {
+        return m_polls.size();
+    }
+
+    size_t conntable::nslots() const noexcept {
+        return m_nslots;
+    }
+
+    int64_t* conntable::slots(conn_id id) noexcept {
+        if (!find(id)) {
+            return nullptr;
+        }
+        return m_slots.data() + id_index(id) * m_nslots;
+    }
+
+    socket::status conntable::recv(conn& c, int& rc) {
+        // reads land in one shared buffer so an idle connection only holds
+        // what it has actually received, not a full read-sized block.
+        if (m_scratch.empty()) {
+            m_scratch.resize(kReadSize);
+        }
+        socket::status st = socket::recv(c.fd, rc, m_scratch.data(), (int)m_scratch.size());
+        if (st == socket::status::success) {
+            c.in.append(m_scratch.data(), (size_t)rc);
+        }
+        return st;
+    }
+
+    socket::status conntable::send(conn& c, const char* data, size_t len) {
+        if (c.out.empty()) {
+            int rc;
+            auto n = (int)(std::min)(len, (size_t)(std::numeric_limits<int>::max)());
+            switch (socket::send(c.fd, rc, data, n)) {
+            case socket::status::success:
+                data += rc;
+                len -= (size_t)rc;
+                break;
+            case socket::status::wait:
+                break;
+            default:
+                return socket::status::failed;
+            }
+        }
+        if (len > 0) {
+            c.out.append(data, len);
+        }
+        return flush(c);
+    }
+
+    socket::status conntable::flush(conn& c) noexcept {
+        while (!c.out.empty()) {
+            int rc;
+            auto len = (int)(std::min)(c.out.size(), (size_t)(std::numeric_limits<int>::max)());
+            switch (socket::send(c.fd, rc, c.out.data(), len)) {
+            case socket::status::wait:
+                return socket::status::wait;
+            case socket::status::success:
+                c.out.consume((size_t)rc);
+                break;
+            default:
+                return socket::status::failed;
+            }
+        }
+        c.out = bytebuffer {};
+        return socket::status::success;
+    }
+
+    bool conntable::wait(int timeout, std::vector<conn_id>& readable, std::vector<conn_id>& writable) {
+        static_assert(sizeof(pollslot) == sizeof(pollfd_t));
+        static_assert(offsetof(pollslot, fd) == offsetof(pollfd_t, fd));
+        static_assert(offsetof(pollslot, events) == offsetof(pollfd_t, events));
+        static_assert(offsetof(pollslot, revents) == offsetof(pollfd_t, revents));
+        if (m_polls.empty()) {
+            // WSAPoll rejects an empty set; all there is to wait for is the timeout.
+            if (timeout > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+            }
+            return true;
+        }
+        for (size_t i = 0; i < m_polls.size(); ++i) {
+            auto& p   = m_polls[i];
+            p.events  = (short)(m_conns[m_pollowner[i]].out.empty() ? POLLIN : (POLLIN | POLLOUT));
+            p.revents = 0;
+        }
+        auto fds = reinterpret_cast<pollfd_t*>(m_polls.data());
+#if defined(_WIN32)
+        int n = ::WSAPoll(fds, (ULONG)m_polls.size(), timeout);
+#else
+        int n = ::poll(fds, (nfds_t)m_polls.size(), timeout);
+        if (n < 0 && errno == EINTR) {
+            return true;
+        }
+#endif
+        if (n < 0) {
+            return false;
+        }
+        for (size_t i = 0; i < m_polls.size() && n > 0; ++i) {
+            auto& p = m_polls[i];
+            if (p.revents == 0) {
+                continue;
+            }
+            --n;
+            auto index = m_pollowner[i];
+            auto id    = ((conn_id)m_conns[index].gen << 32) | index;
+            if (p.revents & (POLLIN | POLLHUP | POLLERR)) {
+                readable.push_back(id);
+            }
+            if (p.revents & POLLOUT) {
+                writable.push_back(id);
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <bee/net/endpoint.h>
+#include <bee/net/fd.h>
+#include <bee/net/socket.h>
+#include <bee/utility/bytebuffer.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bee::net {
+    // Slab of connections addressed by integer ids instead of one userdata
+    // and one Lua table each. Every entry owns its fd, an input and an output
+    // buffer, and a fixed number of integer user slots; a dense pollfd array
+    // is kept alongside so wait() needs no per-call setup.
+    class conntable {
+    public:
+        using conn_id = uint64_t;
+
+        struct conn {
+            fd_t fd;
+            uint32_t gen;
+            uint32_t poll;
+            bytebuffer in;
+            bytebuffer out;
+        };
+
+        explicit conntable(size_t nslots);
+        ~conntable() noexcept;
+        conntable(const conntable&)            = delete;
+        conntable& operator=(const conntable&) = delete;
+
+        conn_id add(fd_t fd);
+        conn* find(conn_id id) noexcept;
+        // removes the entry and hands the fd back to the caller.
+        fd_t detach(conn_id id) noexcept;
+        bool close(conn_id id) noexcept;
+        void clear() noexcept;
+        size_t size() const noexcept;
+        size_t nslots() const noexcept;
+        int64_t* slots(conn_id id) noexcept;
+
+        // appends what the socket has to c.in; rc is the byte count.
+        socket::status recv(conn& c, int& rc);
+        // writes data after anything already queued, queueing the remainder.
+        socket::status send(conn& c, const char* data, size_t len);
+        socket::status flush(conn& c) noexcept;
+        // readable lists ids with input (or hangup); writable lists ids with
+        // queued output whose socket can take more. Returns false on error.
+        bool wait(int timeout, std::vector<conn_id>& readable, std::vector<conn_id>& writable);
+
+    private:
+        // layout-compatible with pollfd / WSAPOLLFD, checked in the .cpp.
+        struct pollslot {
+            fd_t fd;
+            short events;
+            short revents;
+        };
+        void release(uint32_t index) noexcept;
+
+        std::vector<conn> m_conns;
+        std::vector<uint32_t> m_free;
+        std::vector<int64_t> m_slots;
+        std::vector<uint32_t> m_pollowner;
+        std::vector<pollslot> m_polls;
+        std::vector<char> m_scratch;
+        size_t m_nslots;
+    };
+}
@@ -0,0 +1,175 @@
+#include <bee/net/pool.h>
+#include <bee/net/socket.h>
+
+#if defined(_WIN32)
+#    include <winsock2.h>
+#else
+#    include <sys/socket.h>
+#    include <sys/stat.h>
+#endif
+
+namespace bee::net {
+    static std::string endpoint_key(const endpoint& ep) {
+        return { (const char*)ep.addr(), (size_t)ep.addrlen() };
+    }
+
+    // tells a checked-out socket apart from a later one that reuses its
+    // descriptor; 0 once the descriptor is closed.
+    static uint64_t socket_identity(fd_t fd) noexcept {
+#if defined(_WIN32)
+        // handles carry no inode, so only a closed socket is detected here.
+        int type;
+        int len = sizeof(type);
+        return ::getsockopt(fd, SOL_SOCKET, SO_TYPE, (char*)&type, &len) == 0 ? (uint64_t)fd + 1 : 0;
+#else
+        struct stat st;
+        return ::fstat(fd, &st) == 0 ? (uint64_t)st.st_ino + 1 : 0;
+#endif
+    }
+
+    connection_pool::connection_pool(const config& cfg) noexcept
+        : m_config(cfg) {}
+
+    connection_pool::~connection_pool() noexcept {
+        clear();
+    }
+
+    connection_pool::status connection_pool::checkout(const endpoint& ep, fd_t& fd, uint64_t now) {
+        // no sweep of the active set here: it would cost a syscall per checked-out socket.
+        expire(now);
+        auto key = endpoint_key(ep);
+        auto& h  = m_hosts[key];
+        // most recently returned first: it is the least likely to have been dropped by the peer.
+        while (!h.idle.empty()) {
+            fd = h.idle.back().fd;
+            h.idle.pop_back();
+            if (socket::alive(fd)) {
+                h.active++;
+                track(fd, std::move(key));
+                return status::reused;
+            }
+            socket::close(fd);
+        }
+        if (h.active >= m_config.max_per_host) {
+            // some of them may have been closed without checkin.
+            prune(&key);
+        }
+        if (h.active >= m_config.max_per_host) {
+            fd = retired_fd;
+            return status::limit;
+        }
+        fd = socket::open(ep.family() == AF_INET6 ? socket::protocol::tcp6 : socket::protocol::tcp);
+        if (fd == retired_fd) {
+            return status::failed;
+        }
+        status st;
+        switch (socket::connect(fd, ep)) {
+        case socket::fdstat::success:
+            st = status::connected;
+            break;
+        case socket::fdstat::wait:
+            st = status::connecting;
+            break;
+        default:
+            socket::close(fd);
+            fd = retired_fd;
+            return status::failed;
+        }
+        h.active++;
+        track(fd, std::move(key));
+        return st;
+    }
+
+    void connection_pool::track(fd_t fd, std::string&& key) {
+        auto it = m_active.find(fd);
+        if (it != m_active.end()) {
+            // the number is free again, so its previous holder was closed without checkin.
+            drop(it);
+        }
+        m_active.emplace(fd, active_conn { std::move(key), socket_identity(fd) });
+    }
+
+    void connection_pool::drop(std::unordered_map<fd_t, active_conn>::iterator it) noexcept {
+        auto h = m_hosts.find(it->second.key);
+        if (h != m_hosts.end()) {
+            h->second.active--;
+        }
+        m_active.erase(it);
+    }
+
+    void connection_pool::prune(const std::string* key) noexcept {
+        for (auto it = m_active.begin(); it != m_active.end();) {
+            auto cur = it++;
+            if (key && cur->second.key != *key) {
+                continue;
+            }
+            if (socket_identity(cur->first) != cur->second.identity) {
+                drop(cur);
+            }
+        }
+    }
+
+    bool connection_pool::checkin(fd_t fd, bool reuse, uint64_t now) {
+        auto it = m_active.find(fd);
+        if (it == m_active.end()) {
+            return false;
+        }
+        if (socket_identity(fd) != it->second.identity) {
+            // ours was closed behind our back and the number reused; not ours to close.
+            drop(it);
+            return false;
+        }
+        auto& h = m_hosts[it->second.key];
+        h.active--;
+        m_active.erase(it);
+        if (reuse && h.idle.size() < m_config.max_idle && socket::alive(fd)) {
+            h.idle.push_back({ fd, now });
+        }
+        else {
+            socket::close(fd);
+        }
+        return true;
+    }
+
+    size_t connection_pool::evict(uint64_t now) noexcept {
+        prune();
+        return expire(now);
+    }
+
+    size_t connection_pool::expire(uint64_t now) noexcept {
+        size_t n = 0;
+        for (auto it = m_hosts.begin(); it != m_hosts.end();) {
+            auto& idle = it->second.idle;
+            while (!idle.empty() && now - idle.front().since >= m_config.idle_timeout) {
+                socket::close(idle.front().fd);
+                idle.pop_front();
+                n++;
+            }
+            if (idle.empty() && it->second.active == 0) {
+                it = m_hosts.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+        return n;
+    }
+
+    void connection_pool::clear() noexcept {
+        for (auto& [_, h] : m_hosts) {
+            for (auto& c : h.idle) {
+                socket::close(c.fd);
+            }
+            h.idle.clear();
+        }
+    }
+
+    connection_pool::stats connection_pool::get_stats() noexcept {
+        prune();
+        stats s { 0, m_active.size() };
+        for (auto& [_, h] : m_hosts) {
+            s.idle += h.idle.size();
+        }
+        return s;
+    }
+}
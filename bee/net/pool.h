@@ -0,0 +1,72 @@
+#pragma once
+
+#include <bee/net/endpoint.h>
+#include <bee/net/fd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+namespace bee::net {
+    // Keeps idle outbound stream connections per remote endpoint so short
+    // request/response exchanges can skip the socket/connect round trip.
+    // Checked-out fds come back through checkin (reuse=false to discard
+    // them). One closed without checkin stops counting against max_per_host
+    // once it is noticed: by checkin, by a checkout that hits the limit or
+    // reuses its number, or by the full sweep in evict and get_stats.
+    class connection_pool {
+    public:
+        struct config {
+            size_t max_per_host   = 16;
+            size_t max_idle       = 16;
+            uint64_t idle_timeout = 30000;
+        };
+        enum class status {
+            reused,
+            connected,
+            connecting,
+            limit,
+            failed,
+        };
+        struct stats {
+            size_t idle;
+            size_t active;
+        };
+
+        explicit connection_pool(const config& cfg) noexcept;
+        ~connection_pool() noexcept;
+        connection_pool(const connection_pool&)            = delete;
+        connection_pool& operator=(const connection_pool&) = delete;
+
+        status checkout(const endpoint& ep, fd_t& fd, uint64_t now);
+        bool checkin(fd_t fd, bool reuse, uint64_t now);
+        size_t evict(uint64_t now) noexcept;
+        void clear() noexcept;
+        stats get_stats() noexcept;
+
+    private:
+        struct idle_conn {
+            fd_t fd;
+            uint64_t since;
+        };
+        struct host {
+            std::deque<idle_conn> idle;
+            size_t active = 0;
+        };
+        struct active_conn {
+            std::string key;
+            uint64_t identity;
+        };
+        // drops entries whose socket is gone, only those of key if given.
+        void prune(const std::string* key = nullptr) noexcept;
+        void drop(std::unordered_map<fd_t, active_conn>::iterator it) noexcept;
+        void track(fd_t fd, std::string&& key);
+        size_t expire(uint64_t now) noexcept;
+
+        config m_config;
+        std::unordered_map<std::string, host> m_hosts;
+        std::unordered_map<fd_t, active_conn> m_active;
+    };
+}
@@ -0,0 +1,308 @@
+#include <bee/net/resolver.h>
+#include <bee/net/socket.h>
+#if defined(_WIN32)
+#    include <Ws2tcpip.h>
+#else
+#    include <netdb.h>
+#    include <sys/socket.h>
+#endif
+
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <unordered_map>
+
+namespace bee::net {
+    struct resolver::shared {
+        struct task {
+            uint64_t id;
+            std::string host;
+            uint16_t port;
+        };
+        struct cache_entry {
+            std::string addr;
+            clock::time_point expire;
+        };
+
+        ~shared() noexcept {
+            for (auto& fd : notify) {
+                if (fd != retired_fd) {
+                    socket::close(fd);
+                }
+            }
+        }
+
+        void complete(uint64_t id, const std::string& host, uint16_t port, std::string addr, std::string error, bool cacheable);
+        bool lookup_cache(const std::string& key, std::string& addr);
+
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::deque<task> tasks;
+        std::vector<result> results;
+        std::unordered_map<std::string, cache_entry> cache;
+        std::map<std::string, std::string> hosts;
+        clock::duration ttl = std::chrono::seconds(60);
+        uint64_t nextid     = 0;
+        bool stop           = false;
+        fd_t notify[2]      = { retired_fd, retired_fd };
+    };
+
+    static std::string cache_key(const std::string& host, uint16_t port) {
+        std::string key = host;
+        key.push_back(':');
+        key.append(std::to_string(port));
+        return key;
+    }
+
+    // numeric is for stub entries: they must never reach the network.
+    static std::string resolve(const std::string& host, uint16_t port, bool numeric, std::string& error) {
+#if defined(__linux__) && defined(BEE_DISABLE_DLOPEN)
+        auto ep = endpoint::from_hostname(host, port);
+        if (!ep.valid()) {
+            error = "cannot resolve host";
+            return {};
+        }
+        return { (const char*)ep.addr(), (size_t)ep.addrlen() };
+#else
+        addrinfo hint  = {};
+        hint.ai_family = AF_UNSPEC;
+        if (numeric) {
+            hint.ai_flags = AI_NUMERICHOST;
+        }
+        addrinfo* info = nullptr;
+        int err        = ::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hint, &info);
+        if (err != 0) {
+#    if defined(_WIN32)
+            error = gai_strerrorA(err);
+#    else
+            error = err == EAI_SYSTEM ? std::generic_category().message(errno) : gai_strerror(err);
+#    endif
+            return {};
+        }
+        std::string addr;
+        for (addrinfo* i = info; i; i = i->ai_next) {
+            if (i->ai_family == AF_INET || i->ai_family == AF_INET6) {
+                addr.assign((const char*)i->ai_addr, (size_t)i->ai_addrlen);
+                break;
+            }
+        }
+        ::freeaddrinfo(info);
+        if (addr.empty()) {
+            error = "no IPv4 or IPv6 address";
+        }
+        return addr;
+#endif
+    }
+
+    resolver::resolver()
+        : m_shared(std::make_shared<shared>()) {}
+
+    resolver::~resolver() noexcept {
+        stop();
+    }
+
+    bool resolver::start(int nthreads, clock::duration ttl) noexcept {
+        if (!socket::pair(m_shared->notify)) {
+            return false;
+        }
+        m_shared->ttl = ttl;
+        for (int i = 0; i < nthreads; ++i) {
+            auto ud = new (std::nothrow) std::shared_ptr<shared>(m_shared);
+            if (!ud) {
+                break;
+            }
+            thread_handle h = thread_create(worker, ud);
+            if (!h) {
+                delete ud;
+                break;
+            }
+            // stop() never joins: a worker blocked in getaddrinfo would
+            // freeze the caller for the whole DNS timeout.
+            thread_detach(h);
+            m_started = true;
+        }
+        if (!m_started) {
+            stop();
+            return false;
+        }
+        return true;
+    }
+
+    void resolver::stop() noexcept {
+        if (!m_shared) {
+            return;
+        }
+        {
+            std::unique_lock<std::mutex> lk(m_shared->mutex);
+            m_shared->stop = true;
+            m_shared->tasks.clear();
+        }
+        m_shared->cond.notify_all();
+        m_shared.reset();
+    }
+
+    fd_t resolver::fd() const noexcept {
+        return m_shared && m_started ? m_shared->notify[0] : retired_fd;
+    }
+
+    uint64_t resolver::query(const std::string& host, uint16_t port) {
+        auto& s = *m_shared;
+        std::string addr;
+        std::string error;
+        std::string stub;
+        uint64_t id;
+        {
+            std::unique_lock<std::mutex> lk(s.mutex);
+            id           = ++s.nextid;
+            auto host_it = s.hosts.find(host);
+            if (host_it != s.hosts.end()) {
+                stub = host_it->second;
+            }
+            else if (!s.lookup_cache(cache_key(host, port), addr)) {
+                s.tasks.push_back({ id, host, port });
+                lk.unlock();
+                s.cond.notify_one();
+                return id;
+            }
+        }
+        if (!stub.empty()) {
+            addr = resolve(stub, port, true, error);
+        }
+        s.complete(id, host, port, std::move(addr), std::move(error), false);
+        return id;
+    }
+
+    std::vector<resolver::result> resolver::results() {
+        auto& s = *m_shared;
+        char tmp[128];
+        for (;;) {
+            int rc;
+            if (socket::recv(s.notify[0], rc, tmp, sizeof(tmp)) != socket::status::success || rc < (int)sizeof(tmp)) {
+                break;
+            }
+        }
+        std::vector<result> r;
+        std::unique_lock<std::mutex> lk(s.mutex);
+        r.swap(s.results);
+        return r;
+    }
+
+    bool resolver::add_host(const std::string& host, const std::string& ip) {
+        std::string error;
+        if (resolve(ip, 0, true, error).empty()) {
+            return false;
+        }
+        std::unique_lock<std::mutex> lk(m_shared->mutex);
+        m_shared->hosts[host] = ip;
+        return true;
+    }
+
+    bool resolver::load_hosts(const std::string& path) {
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f) {
+            return false;
+        }
+        std::vector<std::string> words;
+        std::string word;
+        bool comment    = false;
+        auto flush_line = [&]() {
+            for (size_t i = 1; i < words.size(); ++i) {
+                if (!add_host(words[i], words[0])) {
+                    break; // not a numeric address: skip the whole line.
+                }
+            }
+            words.clear();
+            comment = false;
+        };
+        for (int c = fgetc(f);; c = fgetc(f)) {
+            if (c == EOF || c == '\n' || c == '#' || isspace(c)) {
+                if (!word.empty()) {
+                    words.push_back(std::move(word));
+                    word.clear();
+                }
+                if (c == '#') {
+                    comment = true;
+                }
+                if (c == EOF || c == '\n') {
+                    flush_line();
+                    if (c == EOF) {
+                        break;
+                    }
+                }
+            }
+            else if (!comment) {
+                word.push_back((char)c);
+            }
+        }
+        fclose(f);
+        return true;
+    }
+
+    void resolver::flush_cache() {
+        std::unique_lock<std::mutex> lk(m_shared->mutex);
+        m_shared->cache.clear();
+    }
+
+    bool resolver::shared::lookup_cache(const std::string& key, std::string& addr) {
+        auto it = cache.find(key);
+        if (it == cache.end()) {
+            return false;
+        }
+        if (it->second.expire <= clock::now()) {
+            cache.erase(it);
+            return false;
+        }
+        addr = it->second.addr;
+        return true;
+    }
+
+    void resolver::shared::complete(uint64_t id, const std::string& host, uint16_t port, std::string addr, std::string error, bool cacheable) {
+        bool wakeup;
+        {
+            std::unique_lock<std::mutex> lk(mutex);
+            if (stop) {
+                return;
+            }
+            if (cacheable && !addr.empty() && ttl.count() > 0) {
+                cache[cache_key(host, port)] = { addr, clock::now() + ttl };
+            }
+            // one byte per batch is enough: results() drains the pipe before
+            // taking the queue, so a later completion always sees it empty.
+            wakeup = results.empty();
+            results.push_back({ id, host, port, std::move(addr), std::move(error) });
+        }
+        if (wakeup) {
+            int rc;
+            char c = 0;
+            socket::send(notify[1], rc, &c, 1);
+        }
+    }
+
+    void resolver::worker(void* ud) noexcept {
+        std::unique_ptr<std::shared_ptr<shared>> owner(static_cast<std::shared_ptr<shared>*>(ud));
+        auto& self = **owner;
+        for (;;) {
+            shared::task t;
+            {
+                std::unique_lock<std::mutex> lk(self.mutex);
+                self.cond.wait(lk, [&] { return self.stop || !self.tasks.empty(); });
+                if (self.stop) {
+                    return;
+                }
+                t = std::move(self.tasks.front());
+                self.tasks.pop_front();
+            }
+            try {
+                std::string error;
+                auto addr = resolve(t.host, t.port, false, error);
+                self.complete(t.id, t.host, t.port, std::move(addr), std::move(error), true);
+            } catch (...) {
+            }
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <bee/net/endpoint.h>
+#include <bee/net/fd.h>
+#include <bee/thread/simplethread.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace bee::net {
+    class resolver {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        struct result {
+            uint64_t id;
+            std::string host;
+            uint16_t port;
+            std::string addr;
+            std::string error;
+        };
+
+        resolver();
+        ~resolver() noexcept;
+        resolver(const resolver&)            = delete;
+        resolver& operator=(const resolver&) = delete;
+
+        bool start(int nthreads, clock::duration ttl) noexcept;
+        void stop() noexcept;
+        fd_t fd() const noexcept;
+        uint64_t query(const std::string& host, uint16_t port);
+        std::vector<result> results();
+        bool add_host(const std::string& host, const std::string& ip);
+        bool load_hosts(const std::string& path);
+        void flush_cache();
+
+    private:
+        // everything the workers touch. A worker stuck in getaddrinfo keeps
+        // it alive after stop() and drops its answer once it returns.
+        struct shared;
+        static void worker(void* ud) noexcept;
+
+        std::shared_ptr<shared> m_shared;
+        bool m_started = false;
+    };
+}
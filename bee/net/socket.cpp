@@ -17,9 +17,18 @@
 #    include <netinet/in.h>
 #    include <netinet/tcp.h>
 #    include <signal.h>
+#    include <sys/socket.h>
+#    include <sys/uio.h>
 #    include <unistd.h>
 #    if defined(__APPLE__)
 #        include <sys/ioctl.h>
+#        include <sys/un.h>
+#    endif
+#    if defined(__linux__)
+#        include <sys/sendfile.h>
+#    elif defined(__APPLE__) || defined(__FreeBSD__)
+#        include <sys/types.h>
+#        include <sys/uio.h>
 #    endif
 #endif
 
@@ -28,10 +37,25 @@
 #include <bee/net/socket.h>
 #include <bee/nonstd/unreachable.h>
 
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
 
 #define net_success(x) ((x) == 0)
 
+#if defined(_WIN32)
+static_assert(sizeof(bee::net::socket::iobuf) == sizeof(WSABUF));
+static_assert(offsetof(bee::net::socket::iobuf, len) == offsetof(WSABUF, len));
+static_assert(offsetof(bee::net::socket::iobuf, buf) == offsetof(WSABUF, buf));
+#else
+static_assert(sizeof(bee::net::socket::iobuf) == sizeof(struct iovec));
+static_assert(offsetof(bee::net::socket::iobuf, buf) == offsetof(struct iovec, iov_base));
+static_assert(offsetof(bee::net::socket::iobuf, len) == offsetof(struct iovec, iov_len));
+#endif
+
 #if defined(__MINGW32__)
 #    define WSA_FLAG_NO_HANDLE_INHERIT 0x80
 #endif
@@ -244,7 +268,223 @@ namespace bee::net::socket {
     }
 #endif
 
+    namespace stats {
+        struct global_counters {
+            std::atomic<uint64_t> bytes_in { 0 };
+            std::atomic<uint64_t> bytes_out { 0 };
+            std::atomic<uint64_t> syscalls { 0 };
+            std::atomic<uint64_t> wait_in { 0 };
+            std::atomic<uint64_t> wait_out { 0 };
+            std::atomic<uint64_t> partial_writes { 0 };
+            std::atomic<uint64_t> connects { 0 };
+            std::atomic<uint64_t> connect_time { 0 };
+        };
+        struct tracked {
+            counters c = {};
+        };
+        static global_counters g_counters;
+        static std::atomic<bool> g_tracking { false };
+        static std::mutex g_mutex;
+        static std::unordered_map<fd_t, tracked> g_fds;
+        // pending connects are timed whether or not per-fd tracking is on,
+        // so the global connect_time covers every counted connect.
+        static std::unordered_map<fd_t, std::chrono::steady_clock::time_point> g_connecting;
+        static std::atomic<size_t> g_nconnecting { 0 };
+
+        static void add(std::atomic<uint64_t>& v, uint64_t n) noexcept {
+            v.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        // runs f on the per-fd entry when tracking is enabled.
+        template <typename F>
+        static void with_fd(fd_t s, F&& f) noexcept {
+            if (!g_tracking.load(std::memory_order_relaxed)) {
+                return;
+            }
+            std::unique_lock<std::mutex> lk(g_mutex);
+            f(g_fds[s]);
+        }
+
+        static void connect_done(fd_t s) noexcept {
+            if (g_nconnecting.load(std::memory_order_relaxed) == 0) {
+                return;
+            }
+            std::unique_lock<std::mutex> lk(g_mutex);
+            auto it = g_connecting.find(s);
+            if (it == g_connecting.end()) {
+                return;
+            }
+            auto us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - it->second).count();
+            g_connecting.erase(it);
+            g_nconnecting.fetch_sub(1, std::memory_order_relaxed);
+            add(g_counters.connect_time, us);
+            if (g_tracking.load(std::memory_order_relaxed)) {
+                auto& t = g_fds[s];
+                t.c.connects++;
+                t.c.connect_time += us;
+            }
+        }
+
+        static status input(fd_t s, status st, int rc) noexcept {
+            add(g_counters.syscalls, 1);
+            if (st == status::success) {
+                add(g_counters.bytes_in, (uint64_t)rc);
+            }
+            else if (st == status::wait) {
+                add(g_counters.wait_in, 1);
+            }
+            if (st == status::success) {
+                connect_done(s);
+            }
+            with_fd(s, [&](tracked& t) {
+                t.c.syscalls++;
+                if (st == status::success) {
+                    t.c.bytes_in += (uint64_t)rc;
+                }
+                else if (st == status::wait) {
+                    t.c.wait_in++;
+                }
+            });
+            return st;
+        }
+
+        static status output(fd_t s, status st, int rc, size_t requested) noexcept {
+            add(g_counters.syscalls, 1);
+            bool partial = st == status::success && (size_t)rc < requested;
+            if (st == status::success) {
+                add(g_counters.bytes_out, (uint64_t)rc);
+            }
+            else if (st == status::wait) {
+                add(g_counters.wait_out, 1);
+            }
+            if (partial) {
+                add(g_counters.partial_writes, 1);
+            }
+            if (st == status::success) {
+                connect_done(s);
+            }
+            with_fd(s, [&](tracked& t) {
+                t.c.syscalls++;
+                if (st == status::success) {
+                    t.c.bytes_out += (uint64_t)rc;
+                }
+                else if (st == status::wait) {
+                    t.c.wait_out++;
+                }
+                if (partial) {
+                    t.c.partial_writes++;
+                }
+            });
+            return st;
+        }
+
+        static void connect_start(fd_t s, fdstat st) noexcept {
+            add(g_counters.syscalls, 1);
+            if (st == fdstat::failed) {
+                return;
+            }
+            add(g_counters.connects, 1);
+            with_fd(s, [&](tracked& t) {
+                t.c.syscalls++;
+                if (st == fdstat::success) {
+                    t.c.connects++;
+                }
+            });
+            if (st == fdstat::wait) {
+                std::unique_lock<std::mutex> lk(g_mutex);
+                if (g_connecting.insert_or_assign(s, std::chrono::steady_clock::now()).second) {
+                    g_nconnecting.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // drops everything recorded for s, so a later fd reusing the number starts clean.
+        static void forget(fd_t s) noexcept {
+            if (!g_tracking.load(std::memory_order_relaxed) && g_nconnecting.load(std::memory_order_relaxed) == 0) {
+                return;
+            }
+            std::unique_lock<std::mutex> lk(g_mutex);
+            g_fds.erase(s);
+            if (g_connecting.erase(s)) {
+                g_nconnecting.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        static size_t iobuf_size(const iobuf* bufs, int n) noexcept {
+            size_t total = 0;
+            for (int i = 0; i < n; ++i) {
+                total += (size_t)bufs[i].len;
+            }
+            return total;
+        }
+    }
+
+    counters global_stats() noexcept {
+        counters c;
+        c.bytes_in       = stats::g_counters.bytes_in.load(std::memory_order_relaxed);
+        c.bytes_out      = stats::g_counters.bytes_out.load(std::memory_order_relaxed);
+        c.syscalls       = stats::g_counters.syscalls.load(std::memory_order_relaxed);
+        c.wait_in        = stats::g_counters.wait_in.load(std::memory_order_relaxed);
+        c.wait_out       = stats::g_counters.wait_out.load(std::memory_order_relaxed);
+        c.partial_writes = stats::g_counters.partial_writes.load(std::memory_order_relaxed);
+        c.connects       = stats::g_counters.connects.load(std::memory_order_relaxed);
+        c.connect_time   = stats::g_counters.connect_time.load(std::memory_order_relaxed);
+        return c;
+    }
+
+    bool fd_stats(fd_t s, counters& c) noexcept {
+        std::unique_lock<std::mutex> lk(stats::g_mutex);
+        auto it = stats::g_fds.find(s);
+        if (it == stats::g_fds.end()) {
+            return false;
+        }
+        c = it->second.c;
+        return true;
+    }
+
+    void forget_stats(fd_t s) noexcept {
+        stats::forget(s);
+    }
+
+    void track_stats(bool enable) noexcept {
+        stats::g_tracking.store(enable, std::memory_order_relaxed);
+        if (!enable) {
+            std::unique_lock<std::mutex> lk(stats::g_mutex);
+            stats::g_fds.clear();
+        }
+    }
+
+    bool tcp_stats(fd_t s, tcpinfo& info) noexcept {
+#if defined(__linux__) && defined(TCP_INFO)
+        struct tcp_info ti;
+        socklen_t len = sizeof(ti);
+        if (!net_success(::getsockopt(s, IPPROTO_TCP, TCP_INFO, &ti, &len))) {
+            return false;
+        }
+        info.rtt           = ti.tcpi_rtt;
+        info.rttvar        = ti.tcpi_rttvar;
+        info.retransmits   = ti.tcpi_retransmits;
+        info.total_retrans = ti.tcpi_total_retrans;
+        info.lost          = ti.tcpi_lost;
+        info.unacked       = ti.tcpi_unacked;
+        info.snd_cwnd      = ti.tcpi_snd_cwnd;
+        info.snd_mss       = ti.tcpi_snd_mss;
+        info.rcv_space     = ti.tcpi_rcv_space;
+        return true;
+#else
+        (void)s;
+        (void)info;
+#    if defined(_WIN32)
+        ::WSASetLastError(WSAEOPNOTSUPP);
+#    else
+        errno = EOPNOTSUPP;
+#    endif
+        return false;
+#endif
+    }
+
     bool close(fd_t s) noexcept {
+        stats::forget(s);
 #if defined _WIN32
         const int ok = ::closesocket(s);
 #else
@@ -324,6 +564,7 @@ namespace bee::net::socket {
             return retired_fd;
         }
 #endif
+        stats::forget(fd);
         return fd;
     }
 
@@ -375,19 +616,135 @@ namespace bee::net::socket {
 #endif
     }
 
-    bool setoption(fd_t s, option opt, int value) noexcept {
+    template <typename T>
+    static bool getoption(fd_t s, int level, int optname, T& v) noexcept {
+        socklen_t len = sizeof(T);
+        const int ok  = ::getsockopt(s, level, optname, (char*)&v, &len);
+        return net_success(ok);
+    }
+
+    struct sockopt {
+        int level;
+        int name;
+    };
+
+#if defined(IPV6_TCLASS)
+    static bool is_ipv6(fd_t s) noexcept {
+        sockaddr_storage ss;
+        socklen_t len = sizeof(ss);
+        if (!net_success(::getsockname(s, (sockaddr*)&ss, &len))) {
+            return false;
+        }
+        return ss.ss_family == AF_INET6;
+    }
+#endif
+
+    static std::optional<sockopt> find_option(fd_t s, option opt) noexcept {
         switch (opt) {
         case option::reuseaddr:
-            return setoption(s, SOL_SOCKET, SO_REUSEADDR, value);
+            return sockopt { SOL_SOCKET, SO_REUSEADDR };
         case option::sndbuf:
-            return setoption(s, SOL_SOCKET, SO_SNDBUF, value);
+            return sockopt { SOL_SOCKET, SO_SNDBUF };
         case option::rcvbuf:
-            return setoption(s, SOL_SOCKET, SO_RCVBUF, value);
+            return sockopt { SOL_SOCKET, SO_RCVBUF };
+        case option::reuseport:
+#if defined(SO_REUSEPORT)
+            return sockopt { SOL_SOCKET, SO_REUSEPORT };
+#else
+            return std::nullopt;
+#endif
+        case option::keepalive:
+            return sockopt { SOL_SOCKET, SO_KEEPALIVE };
+        case option::keepidle:
+#if defined(TCP_KEEPIDLE)
+            return sockopt { IPPROTO_TCP, TCP_KEEPIDLE };
+#elif defined(__APPLE__)
+            return sockopt { IPPROTO_TCP, TCP_KEEPALIVE };
+#else
+            return std::nullopt;
+#endif
+        case option::keepintvl:
+#if defined(TCP_KEEPINTVL)
+            return sockopt { IPPROTO_TCP, TCP_KEEPINTVL };
+#else
+            return std::nullopt;
+#endif
+        case option::keepcnt:
+#if defined(TCP_KEEPCNT)
+            return sockopt { IPPROTO_TCP, TCP_KEEPCNT };
+#else
+            return std::nullopt;
+#endif
+        case option::nodelay:
+            return sockopt { IPPROTO_TCP, TCP_NODELAY };
+        case option::cork:
+#if defined(TCP_CORK)
+            return sockopt { IPPROTO_TCP, TCP_CORK };
+#elif defined(TCP_NOPUSH)
+            return sockopt { IPPROTO_TCP, TCP_NOPUSH };
+#else
+            return std::nullopt;
+#endif
+        case option::quickack:
+#if defined(TCP_QUICKACK)
+            return sockopt { IPPROTO_TCP, TCP_QUICKACK };
+#else
+            return std::nullopt;
+#endif
+        case option::busypoll:
+#if defined(SO_BUSY_POLL)
+            return sockopt { SOL_SOCKET, SO_BUSY_POLL };
+#else
+            return std::nullopt;
+#endif
+        case option::fastopen:
+#if defined(TCP_FASTOPEN)
+            return sockopt { IPPROTO_TCP, TCP_FASTOPEN };
+#else
+            return std::nullopt;
+#endif
+        case option::tos:
+#if defined(IPV6_TCLASS)
+            if (is_ipv6(s)) {
+                return sockopt { IPPROTO_IPV6, IPV6_TCLASS };
+            }
+#endif
+#if defined(IP_TOS)
+            return sockopt { IPPROTO_IP, IP_TOS };
+#else
+            return std::nullopt;
+#endif
         default:
             std::unreachable();
         }
     }
 
+    static bool unsupported_option() noexcept {
+#if defined(_WIN32)
+        ::WSASetLastError(WSAENOPROTOOPT);
+#else
+        errno = ENOPROTOOPT;
+#endif
+        return false;
+    }
+
+    bool setoption(fd_t s, option opt, int value) noexcept {
+        auto o = find_option(s, opt);
+        if (!o) {
+            return unsupported_option();
+        }
+        return setoption(s, o->level, o->name, value);
+    }
+
+    bool getoption(fd_t s, option opt, int& value) noexcept {
+        auto o = find_option(s, opt);
+        if (!o) {
+            return unsupported_option();
+        }
+        value = 0;
+        return getoption(s, o->level, o->name, value);
+    }
+
     void udp_connect_reset(fd_t s) noexcept {
 #if defined _WIN32
         DWORD byte_retruned = 0;
@@ -413,7 +770,7 @@ namespace bee::net::socket {
         return net_success(ok);
     }
 
-    fdstat connect(fd_t s, const endpoint& ep) {
+    static fdstat raw_connect(fd_t s, const endpoint& ep) {
 #if defined _WIN32
         if (!supportUnixDomainSocket() && ep.family() == AF_UNIX) {
             return u_connect(s, ep);
@@ -435,6 +792,12 @@ namespace bee::net::socket {
         return fdstat::failed;
     }
 
+    fdstat connect(fd_t s, const endpoint& ep) {
+        fdstat st = raw_connect(s, ep);
+        stats::connect_start(s, st);
+        return st;
+    }
+
     static fd_t acceptEx(fd_t s, fd_flags fd_flags, struct sockaddr* addr, socklen_t* addrlen) noexcept {
 #if defined(_WIN32) || defined(__APPLE__)
         const fd_t fd = ::accept(s, addr, addrlen);
@@ -458,11 +821,11 @@ namespace bee::net::socket {
 #endif
     }
 
-    fdstat accept(fd_t s, fd_t& newfd, fd_flags fd_flags) noexcept {
-        newfd = acceptEx(s, fd_flags, NULL, NULL);
+    static fdstat accept_status(fd_t newfd) noexcept {
+        stats::add(stats::g_counters.syscalls, 1);
         if (newfd == retired_fd) {
 #if defined _WIN32
-            return fdstat::failed;
+            return wait_finish() ? fdstat::wait : fdstat::failed;
 #else
             if (errno != EAGAIN && errno != ECONNABORTED && errno != EPROTO && errno != EINTR) {
                 return fdstat::failed;
@@ -472,10 +835,21 @@ namespace bee::net::socket {
             }
 #endif
         }
+        stats::forget(newfd);
         return fdstat::success;
     }
 
-    status recv(fd_t s, int& rc, char* buf, int len) noexcept {
+    fdstat accept(fd_t s, fd_t& newfd, fd_flags fd_flags) noexcept {
+        newfd = acceptEx(s, fd_flags, NULL, NULL);
+        return accept_status(newfd);
+    }
+
+    fdstat accept(fd_t s, fd_t& newfd, endpoint_buf& peer, fd_flags fd_flags) noexcept {
+        newfd = acceptEx(s, fd_flags, peer.addr(), peer.addrlen());
+        return accept_status(newfd);
+    }
+
+    static status raw_recv(fd_t s, int& rc, char* buf, int len) noexcept {
         rc = ::recv(s, buf, len, 0);
         if (rc == 0) {
             return status::close;
@@ -486,7 +860,12 @@ namespace bee::net::socket {
         return status::success;
     }
 
-    status send(fd_t s, int& rc, const char* buf, int len) noexcept {
+    status recv(fd_t s, int& rc, char* buf, int len) noexcept {
+        status st = raw_recv(s, rc, buf, len);
+        return stats::input(s, st, rc);
+    }
+
+    static status raw_send(fd_t s, int& rc, const char* buf, int len) noexcept {
         int flags = 0;
 #ifdef MSG_NOSIGNAL
         flags |= MSG_NOSIGNAL;
@@ -498,7 +877,70 @@ namespace bee::net::socket {
         return status::success;
     }
 
-    expected<endpoint, status> recvfrom(fd_t s, int& rc, char* buf, int len) {
+    status send(fd_t s, int& rc, const char* buf, int len) noexcept {
+        status st = raw_send(s, rc, buf, len);
+        return stats::output(s, st, rc, (size_t)len);
+    }
+
+    static status raw_recvv(fd_t s, int& rc, iobuf* bufs, int n) noexcept {
+#if defined(_WIN32)
+        DWORD bytes = 0;
+        DWORD flags = 0;
+        if (::WSARecv(s, (LPWSABUF)bufs, (DWORD)n, &bytes, &flags, NULL, NULL) != 0) {
+            rc = -1;
+            return wait_finish() ? status::wait : status::failed;
+        }
+        rc = (int)bytes;
+#else
+        struct msghdr msg = {};
+        msg.msg_iov       = (struct iovec*)bufs;
+        msg.msg_iovlen    = n;
+        rc                = (int)::recvmsg(s, &msg, 0);
+        if (rc < 0) {
+            return wait_finish() ? status::wait : status::failed;
+        }
+#endif
+        if (rc == 0) {
+            return status::close;
+        }
+        return status::success;
+    }
+
+    status recvv(fd_t s, int& rc, iobuf* bufs, int n) noexcept {
+        status st = raw_recvv(s, rc, bufs, n);
+        return stats::input(s, st, rc);
+    }
+
+    static status raw_sendv(fd_t s, int& rc, const iobuf* bufs, int n) noexcept {
+#if defined(_WIN32)
+        DWORD bytes = 0;
+        if (::WSASend(s, (LPWSABUF)bufs, (DWORD)n, &bytes, 0, NULL, NULL) != 0) {
+            rc = -1;
+            return wait_finish() ? status::wait : status::failed;
+        }
+        rc = (int)bytes;
+#else
+        int flags = 0;
+#    ifdef MSG_NOSIGNAL
+        flags |= MSG_NOSIGNAL;
+#    endif
+        struct msghdr msg = {};
+        msg.msg_iov       = (struct iovec*)bufs;
+        msg.msg_iovlen    = n;
+        rc                = (int)::sendmsg(s, &msg, flags);
+        if (rc < 0) {
+            return wait_finish() ? status::wait : status::failed;
+        }
+#endif
+        return status::success;
+    }
+
+    status sendv(fd_t s, int& rc, const iobuf* bufs, int n) noexcept {
+        status st = raw_sendv(s, rc, bufs, n);
+        return stats::output(s, st, rc, stats::iobuf_size(bufs, n));
+    }
+
+    static expected<endpoint, status> raw_recvfrom(fd_t s, int& rc, char* buf, int len) {
         endpoint_buf tmp(kMaxEndpointSize);
         rc = ::recvfrom(s, buf, len, 0, tmp.addr(), tmp.addrlen());
         if (rc == 0) {
@@ -511,7 +953,18 @@ namespace bee::net::socket {
         return endpoint::from_buf(std::move(tmp));
     }
 
-    status sendto(fd_t s, int& rc, const char* buf, int len, const endpoint& ep) noexcept {
+    expected<endpoint, status> recvfrom(fd_t s, int& rc, char* buf, int len) {
+        auto r = raw_recvfrom(s, rc, buf, len);
+        if (!r) {
+            status st = r.error();
+            stats::input(s, st, rc);
+            return unexpected(std::move(st));
+        }
+        stats::input(s, status::success, rc);
+        return std::move(r.value());
+    }
+
+    static status raw_sendto(fd_t s, int& rc, const char* buf, int len, const endpoint& ep) noexcept {
         int flags = 0;
 #ifdef MSG_NOSIGNAL
         flags |= MSG_NOSIGNAL;
@@ -523,6 +976,355 @@ namespace bee::net::socket {
         return status::success;
     }
 
+    status sendto(fd_t s, int& rc, const char* buf, int len, const endpoint& ep) noexcept {
+        status st = raw_sendto(s, rc, buf, len, ep);
+        return stats::output(s, st, rc, (size_t)len);
+    }
+
+    static status raw_recvmmsg(fd_t s, int& rc, datagram* msgs, int n) noexcept {
+#if defined(__linux__)
+        static constexpr int kMaxBatch = 64;
+        struct mmsghdr hdrs[kMaxBatch];
+        if (n > kMaxBatch) {
+            n = kMaxBatch;
+        }
+        for (int i = 0; i < n; ++i) {
+            memset(&hdrs[i], 0, sizeof(hdrs[i]));
+            hdrs[i].msg_hdr.msg_iov     = (struct iovec*)&msgs[i].buf;
+            hdrs[i].msg_hdr.msg_iovlen  = 1;
+            hdrs[i].msg_hdr.msg_name    = msgs[i].addr;
+            hdrs[i].msg_hdr.msg_namelen = sizeof(msgs[i].addr);
+        }
+        rc = ::recvmmsg(s, hdrs, (unsigned int)n, MSG_DONTWAIT, NULL);
+        if (rc < 0) {
+            return wait_finish() ? status::wait : status::failed;
+        }
+        for (int i = 0; i < rc; ++i) {
+            msgs[i].len     = (int)hdrs[i].msg_len;
+            msgs[i].addrlen = (int)hdrs[i].msg_hdr.msg_namelen;
+        }
+        return status::success;
+#else
+        rc = 0;
+        for (int i = 0; i < n; ++i) {
+            socklen_t addrlen = (socklen_t)sizeof(msgs[i].addr);
+            const int r       = ::recvfrom(s, msgs[i].buf.buf, (int)msgs[i].buf.len, 0, (struct sockaddr*)msgs[i].addr, &addrlen);
+            if (r < 0) {
+                if (rc > 0) {
+                    break;
+                }
+                return wait_finish() ? status::wait : status::failed;
+            }
+            msgs[i].len     = r;
+            msgs[i].addrlen = (int)addrlen;
+            rc++;
+        }
+        return status::success;
+#endif
+    }
+
+    status recvmmsg(fd_t s, int& rc, datagram* msgs, int n) noexcept {
+        status st = raw_recvmmsg(s, rc, msgs, n);
+        int bytes = 0;
+        for (int i = 0; st == status::success && i < rc; ++i) {
+            bytes += msgs[i].len;
+        }
+        stats::input(s, st, bytes);
+        return st;
+    }
+
+    static status raw_sendmmsg(fd_t s, int& rc, datagram* msgs, int n) noexcept {
+        int flags = 0;
+#ifdef MSG_NOSIGNAL
+        flags |= MSG_NOSIGNAL;
+#endif
+#if defined(__linux__)
+        static constexpr int kMaxBatch = 64;
+        struct mmsghdr hdrs[kMaxBatch];
+        if (n > kMaxBatch) {
+            n = kMaxBatch;
+        }
+        for (int i = 0; i < n; ++i) {
+            memset(&hdrs[i], 0, sizeof(hdrs[i]));
+            hdrs[i].msg_hdr.msg_iov     = (struct iovec*)&msgs[i].buf;
+            hdrs[i].msg_hdr.msg_iovlen  = 1;
+            hdrs[i].msg_hdr.msg_name    = msgs[i].addrlen > 0 ? msgs[i].addr : NULL;
+            hdrs[i].msg_hdr.msg_namelen = (socklen_t)msgs[i].addrlen;
+        }
+        rc = ::sendmmsg(s, hdrs, (unsigned int)n, flags);
+        if (rc < 0) {
+            return wait_finish() ? status::wait : status::failed;
+        }
+        for (int i = 0; i < rc; ++i) {
+            msgs[i].len = (int)hdrs[i].msg_len;
+        }
+        return status::success;
+#else
+        rc = 0;
+        for (int i = 0; i < n; ++i) {
+            const struct sockaddr* addr = msgs[i].addrlen > 0 ? (const struct sockaddr*)msgs[i].addr : NULL;
+            const int r                 = ::sendto(s, msgs[i].buf.buf, (int)msgs[i].buf.len, flags, addr, (socklen_t)msgs[i].addrlen);
+            if (r < 0) {
+                if (rc > 0) {
+                    break;
+                }
+                return wait_finish() ? status::wait : status::failed;
+            }
+            msgs[i].len = r;
+            rc++;
+        }
+        return status::success;
+#endif
+    }
+
+    status sendmmsg(fd_t s, int& rc, datagram* msgs, int n) noexcept {
+        status st        = raw_sendmmsg(s, rc, msgs, n);
+        int bytes        = 0;
+        size_t requested = 0;
+        for (int i = 0; i < n; ++i) {
+            if (st == status::success && i < rc) {
+                bytes += msgs[i].len;
+            }
+            requested += (size_t)msgs[i].buf.len;
+        }
+        stats::output(s, st, bytes, requested);
+        return st;
+    }
+
+    static status raw_sendfile(fd_t s, int& rc, file_handle::value_type f, int64_t offset, int len) noexcept {
+#if defined(_WIN32)
+        (void)s;
+        (void)f;
+        (void)offset;
+        (void)len;
+        rc = -1;
+        ::WSASetLastError(WSAEOPNOTSUPP);
+        return status::failed;
+#elif defined(__linux__)
+        off_t off = (off_t)offset;
+        rc        = (int)::sendfile(s, f, &off, (size_t)len);
+        if (rc < 0) {
+            return wait_finish() ? status::wait : status::failed;
+        }
+        return status::success;
+#elif defined(__APPLE__)
+        off_t sent = (off_t)len;
+        if (::sendfile(f, s, (off_t)offset, &sent, NULL, 0) != 0) {
+            if (!wait_finish() || sent == 0) {
+                rc = -1;
+                return wait_finish() ? status::wait : status::failed;
+            }
+        }
+        rc = (int)sent;
+        return status::success;
+#elif defined(__FreeBSD__)
+        off_t sent = 0;
+        if (::sendfile(f, s, (off_t)offset, (size_t)len, NULL, &sent, 0) != 0) {
+            if (!wait_finish() || sent == 0) {
+                rc = -1;
+                return wait_finish() ? status::wait : status::failed;
+            }
+        }
+        rc = (int)sent;
+        return status::success;
+#else
+        char buf[16 * 1024];
+        const ssize_t n = ::pread(f, buf, (size_t)len < sizeof(buf) ? (size_t)len : sizeof(buf), (off_t)offset);
+        if (n <= 0) {
+            rc = (int)n;
+            return n == 0 ? status::success : status::failed;
+        }
+        return raw_send(s, rc, buf, (int)n);
+#endif
+    }
+
+    status sendfile(fd_t s, int& rc, file_handle::value_type f, int64_t offset, int len) noexcept {
+        status st = raw_sendfile(s, rc, f, offset, len);
+        // len is only an upper bound (the file may end first), so a short
+        // transfer is not counted as a partial write.
+        return stats::output(s, st, rc, 0);
+    }
+
+    static status raw_splice(fd_t from, fd_t to, int& rc, int len) noexcept {
+#if defined(__linux__)
+        rc = (int)::splice(from, NULL, to, NULL, (size_t)len, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (rc == 0) {
+            return status::close;
+        }
+        if (rc < 0) {
+            return wait_finish() ? status::wait : status::failed;
+        }
+        return status::success;
+#else
+        (void)from;
+        (void)to;
+        (void)len;
+        rc = -1;
+#    if defined(_WIN32)
+        ::WSASetLastError(WSAEOPNOTSUPP);
+#    else
+        errno = EOPNOTSUPP;
+#    endif
+        return status::failed;
+#endif
+    }
+
+    status splice(fd_t from, fd_t to, int& rc, int len) noexcept {
+        status st = raw_splice(from, to, rc, len);
+        return stats::output(to, st, rc, 0);
+    }
+
+    status sendfd(fd_t s, int& rc, fd_t fd, const char* buf, int len) noexcept {
+#if defined(_WIN32)
+        (void)s;
+        (void)fd;
+        (void)buf;
+        (void)len;
+        rc = -1;
+        ::WSASetLastError(WSAEOPNOTSUPP);
+        return status::failed;
+#else
+        // SCM_RIGHTS needs at least one byte of payload to travel with, and a
+        // made-up byte would end up in the peer's stream.
+        if (len <= 0) {
+            rc    = -1;
+            errno = EINVAL;
+            return status::failed;
+        }
+        struct iovec iov;
+        iov.iov_base = (void*)buf;
+        iov.iov_len  = (size_t)len;
+        union {
+            struct cmsghdr hdr;
+            char buf[CMSG_SPACE(sizeof(int))];
+        } control;
+        memset(&control, 0, sizeof(control));
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov        = &iov;
+        msg.msg_iovlen     = 1;
+        msg.msg_control    = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level     = SOL_SOCKET;
+        cmsg->cmsg_type      = SCM_RIGHTS;
+        cmsg->cmsg_len       = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+        int flags = 0;
+#    ifdef MSG_NOSIGNAL
+        flags |= MSG_NOSIGNAL;
+#    endif
+        ssize_t n = ::sendmsg(s, &msg, flags);
+        if (n < 0) {
+            rc = -1;
+            return wait_finish() ? status::wait : status::failed;
+        }
+        rc = (int)n;
+        return status::success;
+#endif
+    }
+
+    status recvfd(fd_t s, int& rc, fd_t& fd, char* buf, int len) noexcept {
+        fd = retired_fd;
+#if defined(_WIN32)
+        (void)s;
+        (void)buf;
+        (void)len;
+        rc = -1;
+        ::WSASetLastError(WSAEOPNOTSUPP);
+        return status::failed;
+#else
+        struct iovec iov;
+        iov.iov_base = buf;
+        iov.iov_len  = (size_t)len;
+        union {
+            struct cmsghdr hdr;
+            char buf[CMSG_SPACE(sizeof(int) * 4)];
+        } control;
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov        = &iov;
+        msg.msg_iovlen     = 1;
+        msg.msg_control    = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+        int flags          = 0;
+#    if defined(MSG_CMSG_CLOEXEC)
+        flags |= MSG_CMSG_CLOEXEC;
+#    endif
+        ssize_t n = ::recvmsg(s, &msg, flags);
+        if (n < 0) {
+            rc = -1;
+            return wait_finish() ? status::wait : status::failed;
+        }
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+                continue;
+            }
+            size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (size_t i = 0; i < count; ++i) {
+                int received;
+                memcpy(&received, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+                // keep the first descriptor; extra ones would leak otherwise.
+                if (fd == retired_fd) {
+                    fd = received;
+#    if !defined(MSG_CMSG_CLOEXEC)
+                    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+#    endif
+                }
+                else {
+                    ::close(received);
+                }
+            }
+        }
+        rc = (int)n;
+        if (n == 0 && fd == retired_fd) {
+            return status::close;
+        }
+        return status::success;
+#endif
+    }
+
+    bool peercred(fd_t s, credential& cred) noexcept {
+        cred.pid = -1;
+        cred.uid = -1;
+        cred.gid = -1;
+#if defined(__linux__)
+        struct ucred uc;
+        socklen_t len = sizeof(uc);
+        if (!net_success(::getsockopt(s, SOL_SOCKET, SO_PEERCRED, &uc, &len))) {
+            return false;
+        }
+        cred.pid = (int)uc.pid;
+        cred.uid = (int)uc.uid;
+        cred.gid = (int)uc.gid;
+        return true;
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
+        uid_t uid;
+        gid_t gid;
+        if (!net_success(::getpeereid(s, &uid, &gid))) {
+            return false;
+        }
+        cred.uid = (int)uid;
+        cred.gid = (int)gid;
+#    if defined(LOCAL_PEERPID)
+        pid_t pid;
+        socklen_t len = sizeof(pid);
+        if (net_success(::getsockopt(s, SOL_LOCAL, LOCAL_PEERPID, &pid, &len))) {
+            cred.pid = (int)pid;
+        }
+#    endif
+        return true;
+#else
+        (void)s;
+#    if defined(_WIN32)
+        ::WSASetLastError(WSAEOPNOTSUPP);
+#    else
+        errno = EOPNOTSUPP;
+#    endif
+        return false;
+#endif
+    }
+
     std::optional<endpoint> getpeername(fd_t s) {
         endpoint_buf tmp(kMaxEndpointSize);
         const int ok = ::getpeername(s, tmp.addr(), tmp.addrlen());
@@ -566,11 +1368,27 @@ namespace bee::net::socket {
         socklen_t errl = sizeof(err);
         const int ok   = ::getsockopt(s, SOL_SOCKET, SO_ERROR, (char*)&err, &errl);
         if (net_success(ok)) {
+            if (err == 0) {
+                stats::connect_done(s);
+            }
             return std::error_code(err, get_error_category());
         }
         return std::error_code(get_error(), get_error_category());
     }
 
+    bool alive(fd_t s) noexcept {
+        if (errcode(s)) {
+            return false;
+        }
+        char c;
+        const int rc = ::recv(s, &c, 1, MSG_PEEK);
+        if (rc < 0) {
+            return wait_finish();
+        }
+        // eof, or unread bytes an idle connection should never have.
+        return false;
+    }
+
 #if defined(_WIN32)
     bool unnamed_unix_bind(fd_t s) {
         char tmpdir[MAX_PATH];
@@ -2,12 +2,15 @@
 
 #include <bee/net/fd.h>
 #include <bee/nonstd/expected.h>
+#include <bee/utility/file_handle.h>
 
+#include <cstddef>
 #include <optional>
 #include <system_error>
 
 namespace bee::net {
     struct endpoint;
+    struct endpoint_buf;
 }
 
 namespace bee::net::socket {
@@ -42,6 +45,17 @@ namespace bee::net::socket {
         reuseaddr = 0,
         sndbuf,
         rcvbuf,
+        reuseport,
+        keepalive,
+        keepidle,
+        keepintvl,
+        keepcnt,
+        nodelay,
+        cork,
+        quickack,
+        busypoll,
+        fastopen,
+        tos,
     };
 
     enum class fd_flags {
@@ -49,6 +63,57 @@ namespace bee::net::socket {
         nonblock,
     };
 
+    // layout compatible with WSABUF on windows and iovec elsewhere.
+    struct iobuf {
+#if defined(_WIN32)
+        unsigned long len;
+        char* buf;
+#else
+        char* buf;
+        size_t len;
+#endif
+    };
+
+    // peer process of a unix socket; fields the platform cannot report are -1.
+    struct credential {
+        int pid;
+        int uid;
+        int gid;
+    };
+
+    // i/o counters; connect_time is the summed connect latency in microseconds.
+    struct counters {
+        uint64_t bytes_in;
+        uint64_t bytes_out;
+        uint64_t syscalls;
+        uint64_t wait_in;
+        uint64_t wait_out;
+        uint64_t partial_writes;
+        uint64_t connects;
+        uint64_t connect_time;
+    };
+
+    // kernel TCP_INFO subset; times are in microseconds.
+    struct tcpinfo {
+        uint32_t rtt;
+        uint32_t rttvar;
+        uint32_t retransmits;
+        uint32_t total_retrans;
+        uint32_t lost;
+        uint32_t unacked;
+        uint32_t snd_cwnd;
+        uint32_t snd_mss;
+        uint32_t rcv_space;
+    };
+
+    // one message of a recvmmsg/sendmmsg batch; addr holds a raw sockaddr.
+    struct datagram {
+        iobuf buf;
+        int len;
+        int addrlen;
+        alignas(8) std::byte addr[128];
+    };
+
     bool initialize() noexcept;
     fd_t open(protocol protocol, fd_flags flags = fd_flags::nonblock);
     bool pair(fd_t sv[2], fd_flags flags = fd_flags::nonblock);
@@ -56,18 +121,35 @@ namespace bee::net::socket {
     bool close(fd_t s) noexcept;
     bool shutdown(fd_t s, shutdown_flag flag) noexcept;
     bool setoption(fd_t s, option opt, int value) noexcept;
+    bool getoption(fd_t s, option opt, int& value) noexcept;
     void udp_connect_reset(fd_t s) noexcept;
     bool bind(fd_t s, const endpoint& ep);
     bool listen(fd_t s, int backlog) noexcept;
     fdstat connect(fd_t s, const endpoint& ep);
     fdstat accept(fd_t s, fd_t& newfd, fd_flags flags = fd_flags::nonblock) noexcept;
+    fdstat accept(fd_t s, fd_t& newfd, endpoint_buf& peer, fd_flags flags = fd_flags::nonblock) noexcept;
     status recv(fd_t s, int& rc, char* buf, int len) noexcept;
     status send(fd_t s, int& rc, const char* buf, int len) noexcept;
+    status recvv(fd_t s, int& rc, iobuf* bufs, int n) noexcept;
+    status sendv(fd_t s, int& rc, const iobuf* bufs, int n) noexcept;
     expected<endpoint, status> recvfrom(fd_t s, int& rc, char* buf, int len);
     status sendto(fd_t s, int& rc, const char* buf, int len, const endpoint& ep) noexcept;
+    status recvmmsg(fd_t s, int& rc, datagram* msgs, int n) noexcept;
+    status sendmmsg(fd_t s, int& rc, datagram* msgs, int n) noexcept;
+    status sendfile(fd_t s, int& rc, file_handle::value_type f, int64_t offset, int len) noexcept;
+    status splice(fd_t from, fd_t to, int& rc, int len) noexcept;
+    status sendfd(fd_t s, int& rc, fd_t fd, const char* buf, int len) noexcept;
+    status recvfd(fd_t s, int& rc, fd_t& fd, char* buf, int len) noexcept;
+    bool peercred(fd_t s, credential& cred) noexcept;
     std::optional<endpoint> getpeername(fd_t s);
     std::optional<endpoint> getsockname(fd_t s);
     bool unlink(const endpoint& ep);
     std::error_code errcode(fd_t s) noexcept;
+    bool alive(fd_t s) noexcept;
+    counters global_stats() noexcept;
+    bool fd_stats(fd_t s, counters& c) noexcept;
+    void forget_stats(fd_t s) noexcept;
+    void track_stats(bool enable) noexcept;
+    bool tcp_stats(fd_t s, tcpinfo& info) noexcept;
     fd_t dup(fd_t s) noexcept;
 }
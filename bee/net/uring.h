@@ -0,0 +1,77 @@
+#pragma once
+
+#include <bee/net/fd.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bee::net {
+    struct endpoint;
+}
+
+namespace bee::net::uring {
+    struct completion {
+        uint64_t user_data;
+        int32_t res;
+        uint32_t flags;
+        bool more() const noexcept;
+        bool has_buffer() const noexcept;
+        uint16_t buffer_id() const noexcept;
+    };
+
+    struct buffer {
+        void* data;
+        size_t size;
+    };
+
+    class ring {
+    public:
+        ring() noexcept;
+        ~ring() noexcept;
+        ring(const ring&)            = delete;
+        ring& operator=(const ring&) = delete;
+
+        bool init(unsigned entries) noexcept;
+        void close() noexcept;
+        bool valid() const noexcept;
+        unsigned space() const noexcept;
+        unsigned pending() const noexcept;
+
+        bool register_buffers(const buffer* bufs, unsigned n) noexcept;
+        bool unregister_buffers() noexcept;
+
+        bool read(fd_t fd, void* buf, uint32_t len, uint64_t offset, uint64_t user_data, int fixed_index = -1) noexcept;
+        bool write(fd_t fd, const void* buf, uint32_t len, uint64_t offset, uint64_t user_data, int fixed_index = -1) noexcept;
+        bool recv(fd_t fd, void* buf, uint32_t len, uint64_t user_data) noexcept;
+        bool recv_multishot(fd_t fd, uint16_t buf_group, uint64_t user_data) noexcept;
+        bool send(fd_t fd, const void* buf, uint32_t len, uint64_t user_data) noexcept;
+        bool accept(fd_t fd, bool multishot, uint64_t user_data) noexcept;
+        bool connect(fd_t fd, const void* addr, uint32_t addrlen, uint64_t user_data) noexcept;
+        bool provide_buffers(void* base, uint32_t len, uint32_t n, uint16_t buf_group, uint16_t bid, uint64_t user_data) noexcept;
+        bool cancel(uint64_t target, uint64_t user_data) noexcept;
+
+        int submit(unsigned wait_nr = 0) noexcept;
+        size_t harvest(completion* out, size_t max) noexcept;
+
+    private:
+        void* get_sqe() noexcept;
+        int m_fd              = -1;
+        void* m_sq_ptr        = nullptr;
+        void* m_cq_ptr        = nullptr;
+        void* m_sqes          = nullptr;
+        size_t m_sq_size      = 0;
+        size_t m_cq_size      = 0;
+        size_t m_sqes_size    = 0;
+        unsigned* m_sq_head   = nullptr;
+        unsigned* m_sq_tail   = nullptr;
+        unsigned* m_sq_mask   = nullptr;
+        unsigned* m_sq_array  = nullptr;
+        unsigned m_sq_entries = 0;
+        unsigned* m_cq_head   = nullptr;
+        unsigned* m_cq_tail   = nullptr;
+        unsigned* m_cq_mask   = nullptr;
+        void* m_cqes          = nullptr;
+        unsigned m_sqe_tail   = 0;
+        unsigned m_submitted  = 0;
+    };
+}
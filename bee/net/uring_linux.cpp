@@ -0,0 +1,408 @@
+#include <bee/net/uring.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+
+// The kernel uapi header is not used on purpose: older distributions ship a
+// <linux/io_uring.h> without the newer opcodes and fields, while the ABI below
+// is stable across kernel versions.
+#if !defined(__NR_io_uring_setup)
+#    define __NR_io_uring_setup 425
+#endif
+#if !defined(__NR_io_uring_enter)
+#    define __NR_io_uring_enter 426
+#endif
+#if !defined(__NR_io_uring_register)
+#    define __NR_io_uring_register 427
+#endif
+
+namespace bee::net::uring {
+    namespace abi {
+        struct sqe {
+            uint8_t opcode;
+            uint8_t flags;
+            uint16_t ioprio;
+            int32_t fd;
+            uint64_t off;
+            uint64_t addr;
+            uint32_t len;
+            uint32_t op_flags;
+            uint64_t user_data;
+            uint16_t buf_index;
+            uint16_t personality;
+            int32_t splice_fd_in;
+            uint64_t pad[2];
+        };
+        static_assert(sizeof(sqe) == 64);
+
+        struct cqe {
+            uint64_t user_data;
+            int32_t res;
+            uint32_t flags;
+        };
+        static_assert(sizeof(cqe) == 16);
+
+        struct sqring_offsets {
+            uint32_t head;
+            uint32_t tail;
+            uint32_t ring_mask;
+            uint32_t ring_entries;
+            uint32_t flags;
+            uint32_t dropped;
+            uint32_t array;
+            uint32_t resv1;
+            uint64_t resv2;
+        };
+
+        struct cqring_offsets {
+            uint32_t head;
+            uint32_t tail;
+            uint32_t ring_mask;
+            uint32_t ring_entries;
+            uint32_t overflow;
+            uint32_t cqes;
+            uint32_t flags;
+            uint32_t resv1;
+            uint64_t resv2;
+        };
+
+        struct params {
+            uint32_t sq_entries;
+            uint32_t cq_entries;
+            uint32_t flags;
+            uint32_t sq_thread_cpu;
+            uint32_t sq_thread_idle;
+            uint32_t features;
+            uint32_t wq_fd;
+            uint32_t resv[3];
+            sqring_offsets sq_off;
+            cqring_offsets cq_off;
+        };
+
+        struct iovec {
+            void* base;
+            size_t len;
+        };
+
+        enum opcode : uint8_t {
+            op_nop             = 0,
+            op_read_fixed      = 4,
+            op_write_fixed     = 5,
+            op_accept          = 13,
+            op_async_cancel    = 14,
+            op_connect         = 16,
+            op_read            = 22,
+            op_write           = 23,
+            op_send            = 26,
+            op_recv            = 27,
+            op_provide_buffers = 31,
+        };
+
+        constexpr uint8_t sqe_buffer_select   = 1U << 5;
+        constexpr uint32_t feat_single_mmap   = 1U << 0;
+        constexpr uint32_t enter_getevents    = 1U << 0;
+        constexpr uint16_t accept_multishot   = 1U << 0;
+        constexpr uint16_t recv_multishot     = 1U << 1;
+        constexpr uint32_t cqe_f_buffer       = 1U << 0;
+        constexpr uint32_t cqe_f_more         = 1U << 1;
+        constexpr uint32_t cqe_buffer_shift   = 16;
+        constexpr uint64_t off_sq_ring        = 0ULL;
+        constexpr uint64_t off_cq_ring        = 0x8000000ULL;
+        constexpr uint64_t off_sqes           = 0x10000000ULL;
+        constexpr unsigned register_buffers   = 0;
+        constexpr unsigned unregister_buffers = 1;
+    }
+
+    static int sys_setup(unsigned entries, abi::params* p) noexcept {
+        return (int)::syscall(__NR_io_uring_setup, entries, p);
+    }
+
+    static int sys_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) noexcept {
+        return (int)::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+    }
+
+    static int sys_register(int fd, unsigned opcode, const void* arg, unsigned nr_args) noexcept {
+        return (int)::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+    }
+
+    template <typename T>
+    static T* ring_offset(void* base, uint32_t off) noexcept {
+        return reinterpret_cast<T*>(static_cast<std::byte*>(base) + off);
+    }
+
+    static unsigned load_acquire(const unsigned* p) noexcept {
+        return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+    }
+
+    static void store_release(unsigned* p, unsigned v) noexcept {
+        __atomic_store_n(p, v, __ATOMIC_RELEASE);
+    }
+
+    bool completion::more() const noexcept {
+        return (flags & abi::cqe_f_more) != 0;
+    }
+
+    bool completion::has_buffer() const noexcept {
+        return (flags & abi::cqe_f_buffer) != 0;
+    }
+
+    uint16_t completion::buffer_id() const noexcept {
+        return (uint16_t)(flags >> abi::cqe_buffer_shift);
+    }
+
+    ring::ring() noexcept {}
+
+    ring::~ring() noexcept {
+        close();
+    }
+
+    bool ring::init(unsigned entries) noexcept {
+        close();
+        abi::params p;
+        memset(&p, 0, sizeof(p));
+        const int fd = sys_setup(entries, &p);
+        if (fd < 0) {
+            return false;
+        }
+        m_fd      = fd;
+        m_sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        m_cq_size = p.cq_off.cqes + p.cq_entries * sizeof(abi::cqe);
+        if (p.features & abi::feat_single_mmap) {
+            if (m_cq_size > m_sq_size) {
+                m_sq_size = m_cq_size;
+            }
+            m_cq_size = m_sq_size;
+        }
+        m_sq_ptr = ::mmap(NULL, m_sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, abi::off_sq_ring);
+        if (m_sq_ptr == MAP_FAILED) {
+            m_sq_ptr = nullptr;
+            close();
+            return false;
+        }
+        if (p.features & abi::feat_single_mmap) {
+            m_cq_ptr = m_sq_ptr;
+        }
+        else {
+            m_cq_ptr = ::mmap(NULL, m_cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, abi::off_cq_ring);
+            if (m_cq_ptr == MAP_FAILED) {
+                m_cq_ptr = nullptr;
+                close();
+                return false;
+            }
+        }
+        m_sqes_size = p.sq_entries * sizeof(abi::sqe);
+        m_sqes      = ::mmap(NULL, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, abi::off_sqes);
+        if (m_sqes == MAP_FAILED) {
+            m_sqes = nullptr;
+            close();
+            return false;
+        }
+        m_sq_head    = ring_offset<unsigned>(m_sq_ptr, p.sq_off.head);
+        m_sq_tail    = ring_offset<unsigned>(m_sq_ptr, p.sq_off.tail);
+        m_sq_mask    = ring_offset<unsigned>(m_sq_ptr, p.sq_off.ring_mask);
+        m_sq_array   = ring_offset<unsigned>(m_sq_ptr, p.sq_off.array);
+        m_sq_entries = p.sq_entries;
+        m_cq_head    = ring_offset<unsigned>(m_cq_ptr, p.cq_off.head);
+        m_cq_tail    = ring_offset<unsigned>(m_cq_ptr, p.cq_off.tail);
+        m_cq_mask    = ring_offset<unsigned>(m_cq_ptr, p.cq_off.ring_mask);
+        m_cqes       = ring_offset<void>(m_cq_ptr, p.cq_off.cqes);
+        m_sqe_tail   = *m_sq_tail;
+        m_submitted  = m_sqe_tail;
+        return true;
+    }
+
+    void ring::close() noexcept {
+        if (m_sqes) {
+            ::munmap(m_sqes, m_sqes_size);
+            m_sqes = nullptr;
+        }
+        if (m_cq_ptr && m_cq_ptr != m_sq_ptr) {
+            ::munmap(m_cq_ptr, m_cq_size);
+        }
+        m_cq_ptr = nullptr;
+        if (m_sq_ptr) {
+            ::munmap(m_sq_ptr, m_sq_size);
+            m_sq_ptr = nullptr;
+        }
+        if (m_fd != -1) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    bool ring::valid() const noexcept {
+        return m_fd != -1;
+    }
+
+    unsigned ring::space() const noexcept {
+        return m_sq_entries - (m_sqe_tail - load_acquire(m_sq_head));
+    }
+
+    unsigned ring::pending() const noexcept {
+        return m_sqe_tail - m_submitted;
+    }
+
+    bool ring::register_buffers(const buffer* bufs, unsigned n) noexcept {
+        static_assert(sizeof(buffer) == sizeof(abi::iovec));
+        return 0 == sys_register(m_fd, abi::register_buffers, bufs, n);
+    }
+
+    bool ring::unregister_buffers() noexcept {
+        return 0 == sys_register(m_fd, abi::unregister_buffers, NULL, 0);
+    }
+
+    void* ring::get_sqe() noexcept {
+        if (space() == 0) {
+            errno = EBUSY;
+            return nullptr;
+        }
+        const unsigned index = m_sqe_tail & *m_sq_mask;
+        abi::sqe* sqe        = static_cast<abi::sqe*>(m_sqes) + index;
+        memset(sqe, 0, sizeof(*sqe));
+        m_sq_array[index] = index;
+        m_sqe_tail++;
+        return sqe;
+    }
+
+    static abi::sqe* prep(void* p, uint8_t opcode, int fd, uint64_t addr, uint32_t len, uint64_t off, uint64_t user_data) noexcept {
+        abi::sqe* sqe  = static_cast<abi::sqe*>(p);
+        sqe->opcode    = opcode;
+        sqe->fd        = fd;
+        sqe->addr      = addr;
+        sqe->len       = len;
+        sqe->off       = off;
+        sqe->user_data = user_data;
+        return sqe;
+    }
+
+    bool ring::read(fd_t fd, void* buf, uint32_t len, uint64_t offset, uint64_t user_data, int fixed_index) noexcept {
+        void* p = get_sqe();
+        if (!p) {
+            return false;
+        }
+        abi::sqe* sqe = prep(p, fixed_index < 0 ? abi::op_read : abi::op_read_fixed, fd, (uint64_t)buf, len, offset, user_data);
+        if (fixed_index >= 0) {
+            sqe->buf_index = (uint16_t)fixed_index;
+        }
+        return true;
+    }
+
+    bool ring::write(fd_t fd, const void* buf, uint32_t len, uint64_t offset, uint64_t user_data, int fixed_index) noexcept {
+        void* p = get_sqe();
+        if (!p) {
+            return false;
+        }
+        abi::sqe* sqe = prep(p, fixed_index < 0 ? abi::op_write : abi::op_write_fixed, fd, (uint64_t)buf, len, offset, user_data);
+        if (fixed_index >= 0) {
+            sqe->buf_index = (uint16_t)fixed_index;
+        }
+        return true;
+    }
+
+    bool ring::recv(fd_t fd, void* buf, uint32_t len, uint64_t user_data) noexcept {
+        void* p = get_sqe();
+        if (!p) {
+            return false;
+        }
+        prep(p, abi::op_recv, fd, (uint64_t)buf, len, 0, user_data);
+        return true;
+    }
+
+    bool ring::recv_multishot(fd_t fd, uint16_t buf_group, uint64_t user_data) noexcept {
+        void* p = get_sqe();
+        if (!p) {
+            return false;
+        }
+        abi::sqe* sqe  = prep(p, abi::op_recv, fd, 0, 0, 0, user_data);
+        sqe->flags     = abi::sqe_buffer_select;
+        sqe->ioprio    = abi::recv_multishot;
+        sqe->buf_index = buf_group;
+        return true;
+    }
+
+    bool ring::send(fd_t fd, const void* buf, uint32_t len, uint64_t user_data) noexcept {
+        void* p = get_sqe();
+        if (!p) {
+            return false;
+        }
+        abi::sqe* sqe = prep(p, abi::op_send, fd, (uint64_t)buf, len, 0, user_data);
+        sqe->op_flags = MSG_NOSIGNAL;
+        return true;
+    }
+
+    bool ring::accept(fd_t fd, bool multishot, uint64_t user_data) noexcept {
+        void* p = get_sqe();
+        if (!p) {
+            return false;
+        }
+        abi::sqe* sqe = prep(p, abi::op_accept, fd, 0, 0, 0, user_data);
+        sqe->op_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+        if (multishot) {
+            sqe->ioprio = abi::accept_multishot;
+        }
+        return true;
+    }
+
+    bool ring::connect(fd_t fd, const void* addr, uint32_t addrlen, uint64_t user_data) noexcept {
+        void* p = get_sqe();
+        if (!p) {
+            return false;
+        }
+        prep(p, abi::op_connect, fd, (uint64_t)addr, 0, addrlen, user_data);
+        return true;
+    }
+
+    bool ring::provide_buffers(void* base, uint32_t len, uint32_t n, uint16_t buf_group, uint16_t bid, uint64_t user_data) noexcept {
+        void* p = get_sqe();
+        if (!p) {
+            return false;
+        }
+        abi::sqe* sqe  = prep(p, abi::op_provide_buffers, (int)n, (uint64_t)base, len, bid, user_data);
+        sqe->buf_index = buf_group;
+        return true;
+    }
+
+    bool ring::cancel(uint64_t target, uint64_t user_data) noexcept {
+        void* p = get_sqe();
+        if (!p) {
+            return false;
+        }
+        prep(p, abi::op_async_cancel, -1, target, 0, 0, user_data);
+        return true;
+    }
+
+    int ring::submit(unsigned wait_nr) noexcept {
+        const unsigned to_submit = m_sqe_tail - m_submitted;
+        if (to_submit > 0) {
+            store_release(m_sq_tail, m_sqe_tail);
+        }
+        if (to_submit == 0 && wait_nr == 0) {
+            return 0;
+        }
+        int rc;
+        do
+            rc = sys_enter(m_fd, to_submit, wait_nr, wait_nr > 0 ? abi::enter_getevents : 0);
+        while (rc == -1 && errno == EINTR);
+        if (rc >= 0) {
+            m_submitted += (unsigned)rc;
+        }
+        return rc;
+    }
+
+    size_t ring::harvest(completion* out, size_t max) noexcept {
+        unsigned head       = *m_cq_head;
+        const unsigned tail = load_acquire(m_cq_tail);
+        const unsigned mask = *m_cq_mask;
+        size_t n            = 0;
+        for (; head != tail && n < max; ++head, ++n) {
+            const abi::cqe& cqe = static_cast<const abi::cqe*>(m_cqes)[head & mask];
+            out[n]              = { cqe.user_data, cqe.res, cqe.flags };
+        }
+        store_release(m_cq_head, head);
+        return n;
+    }
+}
@@ -3,6 +3,9 @@
 #include <bee/utility/dynarray.h>
 #include <bee/utility/file_handle.h>
 
+#include <cstdint>
+#include <string>
+#include <unordered_map>
 #include <utility>
 
 namespace bee::subprocess {
@@ -43,6 +46,34 @@ namespace bee::subprocess {
         }
     };
 
+    // State shared by a batch of spawns: the environment block is built
+    // once and reused by every spawn, and bare program names are looked up
+    // in PATH once and then launched by absolute path.
+    class spawn_cache {
+    public:
+        explicit spawn_cache(environment&& env);
+        // nullptr means the current process environment.
+        environment::value_type* env() noexcept;
+        // absolute path for a bare program name, or nullptr to let the
+        // platform search for it (names with a separator, misses, windows).
+        const char* resolve(const char* name);
+        void forget(const char* name);
+
+    private:
+        environment env_;
+        std::string path_;
+        std::unordered_map<std::string, std::string> resolved_;
+    };
+
+    // what a process consumed over its lifetime, as reported once it exited.
+    struct resource_usage {
+        uint64_t utime_us;
+        uint64_t stime_us;
+        uint64_t maxrss;
+        uint64_t inblock;
+        uint64_t oublock;
+    };
+
     enum class stdio {
         eInput,
         eOutput,
@@ -65,5 +96,13 @@ namespace bee::subprocess {
         };
         open_result open() noexcept;
         int peek(FILE* f) noexcept;
+        // switches the parent end of a pipe to non-blocking so that it can
+        // be multiplexed with poll/epoll instead of read through a FILE*.
+        // Not available on windows, whose anonymous pipes cannot be polled.
+        bool set_nonblock(file_handle h) noexcept;
+        // > 0 bytes transferred, 0 at end of stream, -1 on error; a
+        // non-blocking end fails with EAGAIN when nothing is ready.
+        int read(file_handle h, char* buf, size_t len) noexcept;
+        int write(file_handle h, const char* buf, size_t len) noexcept;
     }
 }
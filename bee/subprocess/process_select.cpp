@@ -4,12 +4,15 @@
 #if defined(_WIN32)
 #    include <Windows.h>
 #else
+#    include <bee/time/monotonic.h>
+#    include <errno.h>
 #    include <poll.h>
 #endif
 
 namespace bee::subprocess {
-    status process_select(const dynarray<process*>& set, int timeout) {
 #if defined(_WIN32)
+    status process_select(const dynarray<process*>& set, int timeout, std::vector<size_t>& exited) {
+        exited.clear();
         if (set.size() >= MAXIMUM_WAIT_OBJECTS) {
             SetLastError(ERROR_INVALID_PARAMETER);
             return status::failed;
@@ -27,22 +30,77 @@ namespace bee::subprocess {
         if (ret < WAIT_OBJECT_0 || ret > (WAIT_OBJECT_0 + nfds - 1)) {
             return status::failed;
         }
+        // the wait reports only the lowest signaled index; collect the rest.
+        exited.push_back(ret - WAIT_OBJECT_0);
+        for (DWORD i = ret - WAIT_OBJECT_0 + 1; i < nfds; ++i) {
+            if (WaitForSingleObject(fds[i], 0) == WAIT_OBJECT_0) {
+                exited.push_back(i);
+            }
+        }
         return status::success;
+    }
 #else
-        dynarray<pollfd> fds(set.size());
-        nfds_t nfds = 0;
-        for (const auto& p : set) {
-            auto fd     = p->native_handle();
-            fds[nfds++] = { fd, POLLIN | POLLPRI, 0 };
+    // without pidfds there is nothing to block on, so the children are polled.
+    static constexpr int kReapInterval = 10;
+
+    status process_select(const dynarray<process*>& set, int timeout, std::vector<size_t>& exited) {
+        exited.clear();
+        for (size_t i = 0; i < set.size(); ++i) {
+            if (!set[i]->is_running()) {
+                exited.push_back(i);
+            }
         }
-        int ret = poll(fds.data(), nfds, timeout);
-        if (ret == -1) {
-            return status::failed;
+        if (!exited.empty()) {
+            return status::success;
         }
-        if (ret == 0) {
+        if (set.empty()) {
             return status::timeout;
         }
-        return status::success;
-#endif
+        dynarray<pollfd> fds(set.size());
+        bool pollable = true;
+        for (size_t i = 0; i < set.size(); ++i) {
+            int fd = set[i]->fd();
+            if (fd == -1) {
+                pollable = false;
+                break;
+            }
+            fds[i] = { fd, POLLIN, 0 };
+        }
+        uint64_t deadline = timeout < 0 ? 0 : time_monotonic() + timeout;
+        for (;;) {
+            int wait = -1;
+            if (timeout >= 0) {
+                uint64_t now = time_monotonic();
+                wait         = now >= deadline ? 0 : (int)(deadline - now);
+            }
+            int ret;
+            if (pollable) {
+                ret = poll(fds.data(), (nfds_t)fds.size(), wait);
+            }
+            else {
+                ret = poll(nullptr, 0, (wait < 0 || wait > kReapInterval) ? kReapInterval : wait);
+            }
+            if (ret == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return status::failed;
+            }
+            for (size_t i = 0; i < set.size(); ++i) {
+                if (pollable && fds[i].revents == 0) {
+                    continue;
+                }
+                if (!set[i]->is_running()) {
+                    exited.push_back(i);
+                }
+            }
+            if (!exited.empty()) {
+                return status::success;
+            }
+            if (timeout >= 0 && time_monotonic() >= deadline) {
+                return status::timeout;
+            }
+        }
     }
+#endif
 }
@@ -2,6 +2,9 @@
 
 #include <bee/utility/dynarray.h>
 
+#include <cstddef>
+#include <vector>
+
 namespace bee::subprocess {
     class process;
     enum class status {
@@ -9,5 +12,7 @@ namespace bee::subprocess {
         timeout,
         failed,
     };
-    status process_select(const dynarray<process*>& set, int timeout);
+    // waits until at least one process in set has exited; on success the
+    // indices of every exited process are stored in exited.
+    status process_select(const dynarray<process*>& set, int timeout, std::vector<size_t>& exited);
 }
@@ -4,15 +4,20 @@
 #include <bee/subprocess.h>
 #include <bee/utility/dynarray.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <memory.h>
 #include <signal.h>
 #include <spawn.h>
+#include <sys/resource.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
 #include <cassert>
+#include <cstring>
 
 #if defined(__APPLE__)
 #    include <crt_externs.h>
@@ -63,7 +68,8 @@ namespace bee::subprocess {
 
     environment envbuilder::release() {
         char** es = environ;
-        if (es == 0) {
+        if (es == 0 || set_env_.empty()) {
+            // nothing to change; exec passes environ through without copying it.
             return nullptr;
         }
         std::vector<char*> envs;
@@ -98,6 +104,12 @@ namespace bee::subprocess {
         fds_[2] = -1;
     }
 
+    spawn::~spawn() {
+        if (cgroup_fd_ != -1) {
+            close(cgroup_fd_);
+        }
+    }
+
     void spawn::suspended() {
 #if defined(POSIX_SPAWN_START_SUSPENDED)
         // apple extension
@@ -132,6 +144,74 @@ namespace bee::subprocess {
         env_ = std::move(env);
     }
 
+    void spawn::cache(spawn_cache& cache) noexcept {
+        cache_ = &cache;
+    }
+
+    void spawn::limit(int resource, uint64_t value) {
+        limits_.emplace_back(resource, value);
+    }
+
+    bool spawn::cgroup(const char* dir) noexcept {
+        // opened here so that a bad path fails the spawn instead of the child.
+        std::string procs = std::string(dir) + "/cgroup.procs";
+        int fd            = ::open(procs.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd == -1) {
+            return false;
+        }
+        if (cgroup_fd_ != -1) {
+            close(cgroup_fd_);
+        }
+        cgroup_fd_ = fd;
+        return true;
+    }
+
+    spawn_cache::spawn_cache(environment&& env)
+        : env_(std::move(env)) {
+        // posix_spawnp searches the PATH of the parent, so the cache does too.
+        if (const char* path = getenv("PATH")) {
+            path_ = path;
+        }
+    }
+
+    environment::value_type* spawn_cache::env() noexcept {
+        return env_ ? (environment::value_type*)env_ : nullptr;
+    }
+
+    const char* spawn_cache::resolve(const char* name) {
+        if (path_.empty() || name[0] == '\0' || strchr(name, '/')) {
+            return nullptr;
+        }
+        auto it = resolved_.find(name);
+        if (it != resolved_.end()) {
+            return it->second.c_str();
+        }
+        size_t pos = 0;
+        while (pos <= path_.size()) {
+            size_t end = path_.find(':', pos);
+            if (end == std::string::npos) {
+                end = path_.size();
+            }
+            // a relative or empty entry depends on the cwd of each spawn and may
+            // shadow every entry after it, so the whole search is left to posix_spawnp.
+            if (end == pos || path_[pos] != '/') {
+                return nullptr;
+            }
+            std::string full = path_.substr(pos, end - pos) + "/" + name;
+            struct stat st;
+            if (::stat(full.c_str(), &st) == 0 && S_ISREG(st.st_mode) && ::access(full.c_str(), X_OK) == 0) {
+                auto r = resolved_.emplace(name, std::move(full));
+                return r.first->second.c_str();
+            }
+            pos = end + 1;
+        }
+        return nullptr;
+    }
+
+    void spawn_cache::forget(const char* name) {
+        resolved_.erase(name);
+    }
+
 #if defined(__ENVIRONMENT_MAC_OS_X_VERSION_MIN_REQUIRED__) && __ENVIRONMENT_MAC_OS_X_VERSION_MIN_REQUIRED__ >= 101500
 // for posix_spawn_file_actions_addchdir_np
 #    define USE_POSIX_SPAWN 1
@@ -146,7 +226,19 @@ namespace bee::subprocess {
             return false;
         }
         args.push(nullptr);
+        char** envp = env_ ? (char**)env_ : nullptr;
+        if (!envp && cache_) {
+            envp = cache_->env();
+        }
+        if (!envp) {
+            envp = environ;
+        }
+        const char* program = cache_ ? cache_->resolve(args[0]) : nullptr;
 #if defined(USE_POSIX_SPAWN)
+        if (!limits_.empty() || cgroup_fd_ != -1) {
+            // posix_spawn has no hook to run setrlimit or join a cgroup in the child.
+            return exec_fork(args, cwd, envp, program);
+        }
         posix_spawn_file_actions_t actions;
         if (int err = posix_spawn_file_actions_init(&actions)) {
             errno = err;
@@ -182,7 +274,18 @@ namespace bee::subprocess {
             errno = err;
             return false;
         }
-        if (int err = posix_spawnp(&pid, arguments[0], &actions, &attr, arguments, env_)) {
+        int err = ENOENT;
+        if (program) {
+            // posix_spawn skips the PATH walk; glibc implements both with clone(CLONE_VM | CLONE_VFORK).
+            err = posix_spawn(&pid, program, &actions, &attr, arguments, envp);
+            if (err == ENOENT) {
+                cache_->forget(arguments[0]);
+            }
+        }
+        if (err == ENOENT) {
+            err = posix_spawnp(&pid, arguments[0], &actions, &attr, arguments, envp);
+        }
+        if (err) {
             posix_spawn_file_actions_destroy(&actions);
             posix_spawnattr_destroy(&attr);
             errno = err;
@@ -198,32 +301,90 @@ namespace bee::subprocess {
         }
         return true;
 #else
+        return exec_fork(args, cwd, envp, program);
+#endif
+    }
+
+    static bool cloexec_pipe(int fds[2]) noexcept {
+#if defined(__linux__)
+        return ::pipe2(fds, O_CLOEXEC) == 0;
+#else
+        if (::pipe(fds) != 0) {
+            return false;
+        }
+        fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+        fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+        return true;
+#endif
+    }
+
+    [[noreturn]] static void child_fail(int pipefd) noexcept {
+        int err = errno;
+        (void)!::write(pipefd, &err, sizeof(err));
+        _exit(127);
+    }
+
+    bool spawn::exec_fork(args_t& args, const char* cwd, char** envp, const char* program) {
+        // the child reports why it failed to exec through this pipe; a
+        // successful exec closes it and the parent reads eof.
+        int errpipe[2];
+        if (!cloexec_pipe(errpipe)) {
+            return false;
+        }
         pid_t pid = fork();
         if (pid == -1) {
+            int err = errno;
+            close(errpipe[0]);
+            close(errpipe[1]);
+            errno = err;
             return false;
         }
         if (pid == 0) {
-            // if (detached_) {
-            //     setsid();
-            // }
+            close(errpipe[0]);
+#if defined(POSIX_SPAWN_SETSID)
+            if ((spawnattr_ & POSIX_SPAWN_SETSID) && setsid() == -1) {
+                child_fail(errpipe[1]);
+            }
+#endif
             for (int i = 0; i < 3; ++i) {
                 if (fds_[i] > 0) {
                     if (dup2(fds_[i], i) == -1) {
-                        _exit(127);
+                        child_fail(errpipe[1]);
                     }
                 }
             }
-            if (env_) {
-                environ = env_;
+            for (auto const& [resource, value] : limits_) {
+                struct rlimit rl;
+                rl.rlim_cur = rl.rlim_max = (rlim_t)value;
+                if (setrlimit(resource, &rl) == -1) {
+                    child_fail(errpipe[1]);
+                }
+            }
+            if (cgroup_fd_ != -1 && ::write(cgroup_fd_, "0", 1) != 1) {
+                child_fail(errpipe[1]);
             }
+            environ = envp;
             if (cwd && chdir(cwd)) {
-                _exit(127);
+                child_fail(errpipe[1]);
+            }
+            if (program) {
+                execv(program, args.data());
             }
-            // if (suspended_) {
-            //     ::kill(getpid(), SIGSTOP);
-            // }
             execvp(args[0], args.data());
-            _exit(127);
+            child_fail(errpipe[1]);
+        }
+        close(errpipe[1]);
+        int err = 0;
+        ssize_t n;
+        do
+            n = ::read(errpipe[0], &err, sizeof(err));
+        while (n == -1 && errno == EINTR);
+        close(errpipe[0]);
+        if (n == sizeof(err)) {
+            int stat;
+            while (::waitpid(pid, &stat, 0) == -1 && errno == EINTR) {}
+            errno = err;
+            return false;
         }
         pid_ = pid;
         for (int i = 0; i < 3; ++i) {
@@ -232,14 +393,27 @@ namespace bee::subprocess {
             }
         }
         return true;
+    }
+
+    static int open_pidfd(pid_t pid) noexcept {
+#if defined(__linux__) && defined(SYS_pidfd_open)
+        // the child cannot be reaped before we wait for it, so the pid is still ours.
+        return pid > 0 ? (int)syscall(SYS_pidfd_open, pid, 0) : -1;
+#else
+        (void)pid;
+        return -1;
 #endif
     }
 
     process::process(spawn& spawn) noexcept
-        : pid(spawn.pid_) {}
+        : pid(spawn.pid_)
+        , pidfd(open_pidfd(spawn.pid_)) {}
 
     process::~process() noexcept {
         detach();
+        if (pidfd != -1) {
+            close(pidfd);
+        }
     }
 
     bool process::detach() noexcept {
@@ -254,6 +428,10 @@ namespace bee::subprocess {
         return pid;
     }
 
+    int process::fd() const noexcept {
+        return pidfd;
+    }
+
     bool process::kill(int signum) noexcept {
         return 0 == ::kill(pid, signum);
     }
@@ -268,19 +446,36 @@ namespace bee::subprocess {
         return 0;
     }
 
+    static resource_usage make_usage(const struct rusage& ru) {
+        resource_usage r;
+        r.utime_us = (uint64_t)ru.ru_utime.tv_sec * 1000000 + ru.ru_utime.tv_usec;
+        r.stime_us = (uint64_t)ru.ru_stime.tv_sec * 1000000 + ru.ru_stime.tv_usec;
+#if defined(__APPLE__)
+        r.maxrss = (uint64_t)ru.ru_maxrss;
+#else
+        // kilobytes everywhere but macOS.
+        r.maxrss = (uint64_t)ru.ru_maxrss * 1024;
+#endif
+        r.inblock = (uint64_t)ru.ru_inblock;
+        r.oublock = (uint64_t)ru.ru_oublock;
+        return r;
+    }
+
     bool process::is_running() noexcept {
         if (status) {
             return false;
         }
         int stat;
-        int r = ::waitpid(pid, &stat, WNOHANG);
+        struct rusage ru;
+        int r = ::wait4(pid, &stat, WNOHANG, &ru);
         if (r == 0) {
             return true;
         }
         if (r == -1) {
             return false;
         }
-        status = make_status(stat);
+        status    = make_status(stat);
+        resources = make_usage(ru);
         return false;
     }
 
@@ -289,16 +484,22 @@ namespace bee::subprocess {
             return status;
         }
         int r, stat;
+        struct rusage ru;
         do
-            r = ::waitpid(pid, &stat, 0);
+            r = ::wait4(pid, &stat, 0, &ru);
         while (r == -1 && errno == EINTR);
         if (r == -1) {
             return std::nullopt;
         }
-        status = make_status(stat);
+        status    = make_status(stat);
+        resources = make_usage(ru);
         return status;
     }
 
+    std::optional<resource_usage> process::usage() const noexcept {
+        return resources;
+    }
+
     bool process::resume() noexcept {
         return kill(SIGCONT);
     }
@@ -325,5 +526,22 @@ namespace bee::subprocess {
             }
             return rc;
         }
+        bool set_nonblock(file_handle h) noexcept {
+            int flags = fcntl(h.value(), F_GETFL, 0);
+            if (flags == -1) {
+                return false;
+            }
+            return fcntl(h.value(), F_SETFL, flags | O_NONBLOCK) != -1;
+        }
+        int read(file_handle h, char* buf, size_t len) noexcept {
+            return (int)recv(h.value(), buf, len, 0);
+        }
+        int write(file_handle h, const char* buf, size_t len) noexcept {
+#if defined(MSG_NOSIGNAL)
+            return (int)send(h.value(), buf, len, MSG_NOSIGNAL);
+#else
+            return (int)send(h.value(), buf, len, 0);
+#endif
+        }
     }
 }
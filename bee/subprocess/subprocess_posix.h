@@ -6,6 +6,7 @@
 #include <cstdint>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace bee::subprocess {
@@ -30,12 +31,19 @@ namespace bee::subprocess {
         bool detach() noexcept;
         process_id get_id() const noexcept;
         process_handle native_handle() const noexcept;
+        // pidfd that turns readable once the process exits, or -1 where
+        // pidfd_open is unavailable (non-Linux, kernels before 5.3).
+        int fd() const noexcept;
         bool kill(int signum) noexcept;
         bool is_running() noexcept;
         std::optional<uint32_t> wait() noexcept;
+        // filled in by whichever of is_running() and wait() reaps the process.
+        std::optional<resource_usage> usage() const noexcept;
         bool resume() noexcept;
         pid_t pid;
+        int pidfd;
         std::optional<uint32_t> status;
+        std::optional<resource_usage> resources;
     };
 
     struct args_t {
@@ -67,14 +75,27 @@ namespace bee::subprocess {
 
     public:
         spawn();
+        ~spawn();
         void suspended();
         void detached();
         void redirect(stdio type, file_handle f);
         void env(environment&& env);
+        // takes the environment and program lookups from cache, which must
+        // outlive exec().
+        void cache(spawn_cache& cache) noexcept;
+        // setrlimit(resource, value) in the child, both soft and hard.
+        void limit(int resource, uint64_t value);
+        // moves the child into the cgroup v2 directory before it execs.
+        bool cgroup(const char* dir) noexcept;
         bool exec(args_t& args, const char* cwd);
 
     private:
-        environment env_ = nullptr;
+        bool exec_fork(args_t& args, const char* cwd, char** envp, const char* program);
+
+        environment env_    = nullptr;
+        spawn_cache* cache_ = nullptr;
+        std::vector<std::pair<int, uint64_t>> limits_;
+        int cgroup_fd_ = -1;
         int fds_[3];
         pid_t pid_       = -1;
         short spawnattr_ = 0;
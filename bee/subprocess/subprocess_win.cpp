@@ -1,5 +1,6 @@
 #include <Shobjidl.h>
 #include <Windows.h>
+#include <psapi.h>
 #include <bee/net/socket.h>
 #include <bee/nonstd/bit.h>
 #include <bee/nonstd/format.h>
@@ -363,7 +364,8 @@ namespace bee::subprocess {
             return false;
         }
         const wchar_t* application = search_path_ ? 0 : args[0].c_str();
-        if (env_) {
+        wchar_t* envp              = env_ ? (wchar_t*)env_ : (cache_ ? cache_->env() : nullptr);
+        if (envp) {
             flags_ |= CREATE_UNICODE_ENVIRONMENT;
         }
         STARTUPINFOW si;
@@ -383,7 +385,7 @@ namespace bee::subprocess {
             si.dwFlags |= STARTF_USESHOWWINDOW;
             si.wShowWindow = SW_HIDE;
         }
-        if (!::CreateProcessW(application, command_line.data(), NULL, NULL, inherit_handle_, flags_ | NORMAL_PRIORITY_CLASS, env_, cwd, &si, (LPPROCESS_INFORMATION)&pi_)) {
+        if (!::CreateProcessW(application, command_line.data(), NULL, NULL, inherit_handle_, flags_ | NORMAL_PRIORITY_CLASS, envp, cwd, &si, (LPPROCESS_INFORMATION)&pi_)) {
             startupinfo_release(si);
             return false;
         }
@@ -401,6 +403,24 @@ namespace bee::subprocess {
         env_ = std::move(env);
     }
 
+    void spawn::cache(spawn_cache& cache) noexcept {
+        cache_ = &cache;
+    }
+
+    spawn_cache::spawn_cache(environment&& env)
+        : env_(std::move(env)) {}
+
+    environment::value_type* spawn_cache::env() noexcept {
+        return env_ ? (environment::value_type*)env_ : nullptr;
+    }
+
+    const char* spawn_cache::resolve(const char*) {
+        // CreateProcessW and searchPath do their own lookup.
+        return nullptr;
+    }
+
+    void spawn_cache::forget(const char*) {}
+
     static_assert(sizeof(PROCESS_INFORMATION) == sizeof(process));
 
     process::process() noexcept
@@ -447,6 +467,39 @@ namespace bee::subprocess {
         return proc;
     }
 
+    static uint64_t filetime_us(const FILETIME& ft) noexcept {
+        ULARGE_INTEGER v;
+        v.LowPart  = ft.dwLowDateTime;
+        v.HighPart = ft.dwHighDateTime;
+        return v.QuadPart / 10;
+    }
+
+    std::optional<resource_usage> process::usage() const noexcept {
+        if (::WaitForSingleObject(hProcess, 0) != WAIT_OBJECT_0) {
+            return std::nullopt;
+        }
+        FILETIME creation, exit, kernel, user;
+        if (!::GetProcessTimes(hProcess, &creation, &exit, &kernel, &user)) {
+            return std::nullopt;
+        }
+        resource_usage r;
+        r.utime_us = filetime_us(user);
+        r.stime_us = filetime_us(kernel);
+        r.maxrss   = 0;
+        r.inblock  = 0;
+        r.oublock  = 0;
+        PROCESS_MEMORY_COUNTERS pmc;
+        if (::K32GetProcessMemoryInfo(hProcess, &pmc, sizeof(pmc))) {
+            r.maxrss = pmc.PeakWorkingSetSize;
+        }
+        IO_COUNTERS io;
+        if (::GetProcessIoCounters(hProcess, &io)) {
+            r.inblock = io.ReadOperationCount;
+            r.oublock = io.WriteOperationCount;
+        }
+        return r;
+    }
+
     std::optional<uint32_t> process::wait() noexcept {
         ::WaitForSingleObject(hProcess, INFINITE);
         DWORD status = 0;
@@ -508,5 +561,26 @@ namespace bee::subprocess {
             }
             return -1;
         }
+
+        bool set_nonblock(file_handle) noexcept {
+            SetLastError(ERROR_NOT_SUPPORTED);
+            return false;
+        }
+
+        int read(file_handle h, char* buf, size_t len) noexcept {
+            DWORD rlen = 0;
+            if (!ReadFile(h.value(), buf, (DWORD)len, &rlen, NULL)) {
+                return GetLastError() == ERROR_BROKEN_PIPE ? 0 : -1;
+            }
+            return (int)rlen;
+        }
+
+        int write(file_handle h, const char* buf, size_t len) noexcept {
+            DWORD wlen = 0;
+            if (!WriteFile(h.value(), buf, (DWORD)len, &wlen, NULL)) {
+                return -1;
+            }
+            return (int)wlen;
+        }
     }
 }
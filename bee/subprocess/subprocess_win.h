@@ -62,6 +62,7 @@ namespace bee::subprocess {
         bool is_running() noexcept;
         bool kill(int signum) noexcept;
         std::optional<uint32_t> wait() noexcept;
+        std::optional<resource_usage> usage() const noexcept;
         bool resume() noexcept;
 
     private:
@@ -101,10 +102,13 @@ namespace bee::subprocess {
         void detached() noexcept;
         void redirect(stdio type, file_handle h) noexcept;
         void env(environment&& env) noexcept;
+        // takes the environment from cache, which must outlive exec().
+        void cache(spawn_cache& cache) noexcept;
         bool exec(const args_t& args, const wchar_t* cwd);
 
     private:
-        environment env_ = nullptr;
+        environment env_     = nullptr;
+        spawn_cache* cache_ = nullptr;
         process pi_;
         os_handle fds_[3];
         uint32_t flags_      = 0;
@@ -40,6 +40,11 @@ namespace bee {
         pthread_join(pid, NULL);
     }
 
+    void thread_detach(thread_handle handle) noexcept {
+        pthread_t pid = (pthread_t)handle;
+        pthread_detach(pid);
+    }
+
     void thread_sleep(int msec) noexcept {
         usleep(msec * 1000);
     }
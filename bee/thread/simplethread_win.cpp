@@ -39,6 +39,10 @@ namespace bee {
         CloseHandle(h);
     }
 
+    void thread_detach(thread_handle handle) noexcept {
+        CloseHandle((HANDLE)handle);
+    }
+
     void thread_sleep(int msec) noexcept {
         Sleep(msec);
     }
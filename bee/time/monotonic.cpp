@@ -0,0 +1,19 @@
+#include <bee/time/monotonic.h>
+
+#if defined(_WIN32)
+#    include <Windows.h>
+#else
+#    include <time.h>
+#endif
+
+namespace bee {
+    uint64_t time_monotonic() noexcept {
+#if defined(_WIN32)
+        return GetTickCount64();
+#else
+        struct timespec ti;
+        clock_gettime(CLOCK_MONOTONIC, &ti);
+        return (uint64_t)ti.tv_sec * 1000 + ti.tv_nsec / 1000000;
+#endif
+    }
+}
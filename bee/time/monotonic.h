@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstdint>
+
+namespace bee {
+    uint64_t time_monotonic() noexcept;
+}
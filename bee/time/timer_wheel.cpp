@@ -0,0 +1,222 @@
+#include <bee/time/timer_wheel.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace bee {
+    static constexpr int kLevels         = 5;
+    static constexpr uint32_t kRootSlots = 256;
+    static constexpr uint32_t kNodeSlots = 64;
+    static constexpr uint64_t kMaxDelay  = (uint64_t)1 << 32;
+
+    static constexpr int level_shift(int level) noexcept {
+        return level == 0 ? 0 : 8 + 6 * (level - 1);
+    }
+    static constexpr uint64_t level_range(int level) noexcept {
+        return (uint64_t)1 << (8 + 6 * level);
+    }
+    static constexpr uint32_t level_mask(int level) noexcept {
+        return level == 0 ? kRootSlots - 1 : kNodeSlots - 1;
+    }
+    static constexpr uint32_t level_base(int level) noexcept {
+        return level == 0 ? 0 : kRootSlots + (level - 1) * kNodeSlots;
+    }
+    static constexpr uint32_t kTotalSlots = level_base(kLevels);
+
+    timer_wheel::timer_wheel(uint64_t now) noexcept
+        : m_slots(kTotalSlots, npos)
+        , m_now(now) {}
+
+    timer_wheel::timer_id timer_wheel::add(uint64_t expire) {
+        uint32_t index;
+        if (m_free.empty()) {
+            index = (uint32_t)m_nodes.size();
+            m_nodes.push_back({ 0, npos, npos, npos, 1 });
+        }
+        else {
+            index = m_free.back();
+            m_free.pop_back();
+        }
+        auto& n  = m_nodes[index];
+        n.expire = (std::max)(expire, m_now + 1);
+        place(index);
+        m_size++;
+        return ((timer_id)n.gen << 32) | index;
+    }
+
+    bool timer_wheel::cancel(timer_id id) noexcept {
+        node* n = find(id);
+        if (!n) {
+            return false;
+        }
+        uint32_t index = (uint32_t)id;
+        unlink(index);
+        release(index);
+        m_size--;
+        return true;
+    }
+
+    bool timer_wheel::reset(timer_id id, uint64_t expire) noexcept {
+        node* n = find(id);
+        if (!n) {
+            return false;
+        }
+        uint32_t index = (uint32_t)id;
+        unlink(index);
+        n->expire = (std::max)(expire, m_now + 1);
+        place(index);
+        return true;
+    }
+
+    bool timer_wheel::contains(timer_id id) const noexcept {
+        return find(id) != nullptr;
+    }
+
+    int64_t timer_wheel::next_timeout(uint64_t now) const noexcept {
+        if (m_size == 0) {
+            return -1;
+        }
+        uint64_t best = next_tick();
+        return best <= now ? 0 : (int64_t)(best - now);
+    }
+
+    uint64_t timer_wheel::next_tick() const noexcept {
+        uint64_t best = (std::numeric_limits<uint64_t>::max)();
+        for (uint32_t i = 0; i < kRootSlots; ++i) {
+            if (m_slots[(m_now + i) & level_mask(0)] != npos) {
+                best = m_now + i;
+                break;
+            }
+        }
+        for (int level = 1; level < kLevels; ++level) {
+            const uint64_t cur = m_now >> level_shift(level);
+            for (uint32_t j = 1; j <= kNodeSlots; ++j) {
+                if (m_slots[level_base(level) + ((cur + j) & level_mask(level))] != npos) {
+                    best = (std::min)(best, (cur + j) << level_shift(level));
+                    break;
+                }
+            }
+        }
+        return best;
+    }
+
+    void timer_wheel::expire(uint64_t now, std::vector<timer_id>& out, size_t max) {
+        drain(out, max);
+        while (m_now < now && out.size() < max) {
+            if (m_size == 0) {
+                m_now = now;
+                break;
+            }
+            // every tick before the next occupied slot or cascade point is
+            // empty, so jump straight there instead of walking each one.
+            m_now = (std::min)(next_tick(), now);
+            if ((m_now & level_mask(0)) == 0) {
+                for (int level = 1; level < kLevels; ++level) {
+                    cascade(level);
+                    if (((m_now >> level_shift(level)) & level_mask(level)) != 0) {
+                        break;
+                    }
+                }
+            }
+            drain(out, max);
+        }
+    }
+
+    size_t timer_wheel::size() const noexcept {
+        return m_size;
+    }
+
+    uint64_t timer_wheel::now() const noexcept {
+        return m_now;
+    }
+
+    const timer_wheel::node* timer_wheel::find(timer_id id) const noexcept {
+        uint32_t index = (uint32_t)id;
+        if (index >= m_nodes.size()) {
+            return nullptr;
+        }
+        const node& n = m_nodes[index];
+        if (n.slot == npos || n.gen != (uint32_t)(id >> 32)) {
+            return nullptr;
+        }
+        return &n;
+    }
+
+    timer_wheel::node* timer_wheel::find(timer_id id) noexcept {
+        return const_cast<node*>(static_cast<const timer_wheel*>(this)->find(id));
+    }
+
+    void timer_wheel::place(uint32_t index) noexcept {
+        uint64_t expire = (std::max)(m_nodes[index].expire, m_now);
+        uint64_t delta  = expire - m_now;
+        if (delta >= kMaxDelay) {
+            // parked in the top level; re-placed with the real deadline on cascade.
+            expire = m_now + kMaxDelay - 1;
+            delta  = kMaxDelay - 1;
+        }
+        for (int level = 0; level < kLevels; ++level) {
+            if (delta < level_range(level)) {
+                link(index, level_base(level) + (uint32_t)((expire >> level_shift(level)) & level_mask(level)));
+                return;
+            }
+        }
+    }
+
+    void timer_wheel::link(uint32_t index, uint32_t slot) noexcept {
+        auto& n = m_nodes[index];
+        n.slot  = slot;
+        n.prev  = npos;
+        n.next  = m_slots[slot];
+        if (n.next != npos) {
+            m_nodes[n.next].prev = index;
+        }
+        m_slots[slot] = index;
+    }
+
+    void timer_wheel::unlink(uint32_t index) noexcept {
+        auto& n = m_nodes[index];
+        if (n.prev != npos) {
+            m_nodes[n.prev].next = n.next;
+        }
+        else {
+            m_slots[n.slot] = n.next;
+        }
+        if (n.next != npos) {
+            m_nodes[n.next].prev = n.prev;
+        }
+        n.prev = npos;
+        n.next = npos;
+    }
+
+    void timer_wheel::release(uint32_t index) noexcept {
+        auto& n = m_nodes[index];
+        n.slot  = npos;
+        if (++n.gen == 0) {
+            n.gen = 1;
+        }
+        m_free.push_back(index);
+    }
+
+    void timer_wheel::cascade(int level) noexcept {
+        uint32_t slot  = level_base(level) + (uint32_t)((m_now >> level_shift(level)) & level_mask(level));
+        uint32_t index = m_slots[slot];
+        m_slots[slot]  = npos;
+        while (index != npos) {
+            uint32_t next = m_nodes[index].next;
+            place(index);
+            index = next;
+        }
+    }
+
+    void timer_wheel::drain(std::vector<timer_id>& out, size_t max) {
+        uint32_t slot = (uint32_t)(m_now & level_mask(0));
+        while (m_slots[slot] != npos && out.size() < max) {
+            uint32_t index = m_slots[slot];
+            timer_id id    = ((timer_id)m_nodes[index].gen << 32) | index;
+            unlink(index);
+            release(index);
+            m_size--;
+            out.push_back(id);
+        }
+    }
+}
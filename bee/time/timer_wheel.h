@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bee {
+    // Hierarchical timing wheel with a 1ms tick: 256 slots at the lowest
+    // level and four 64-slot levels above it, covering ~49 days. Timers
+    // further out are parked in the top level and re-placed when it cascades.
+    class timer_wheel {
+    public:
+        using timer_id = uint64_t;
+
+        // times are absolute milliseconds on the caller's monotonic clock.
+        explicit timer_wheel(uint64_t now) noexcept;
+        timer_id add(uint64_t expire);
+        bool cancel(timer_id id) noexcept;
+        bool reset(timer_id id, uint64_t expire) noexcept;
+        bool contains(timer_id id) const noexcept;
+        // milliseconds from now until the earliest timer may fire, or -1 when
+        // there are none. It never overshoots; for timers in the upper levels
+        // it is the next cascade point, where a tighter bound is available.
+        int64_t next_timeout(uint64_t now) const noexcept;
+        // fires everything due at or before now, at most max timers per call.
+        void expire(uint64_t now, std::vector<timer_id>& out, size_t max);
+        size_t size() const noexcept;
+        uint64_t now() const noexcept;
+
+    private:
+        static constexpr uint32_t npos = (uint32_t)-1;
+        struct node {
+            uint64_t expire;
+            uint32_t prev;
+            uint32_t next;
+            uint32_t slot;
+            uint32_t gen;
+        };
+        const node* find(timer_id id) const noexcept;
+        node* find(timer_id id) noexcept;
+        void place(uint32_t index) noexcept;
+        void link(uint32_t index, uint32_t slot) noexcept;
+        void unlink(uint32_t index) noexcept;
+        void release(uint32_t index) noexcept;
+        void cascade(int level) noexcept;
+        // the first tick after m_now with a due slot or a cascade to run.
+        uint64_t next_tick() const noexcept;
+        void drain(std::vector<timer_id>& out, size_t max);
+
+        std::vector<node> m_nodes;
+        std::vector<uint32_t> m_free;
+        std::vector<uint32_t> m_slots;
+        uint64_t m_now;
+        size_t m_size = 0;
+    };
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+namespace bee {
+    class bytebuffer {
+    public:
+        static constexpr size_t npos         = (size_t)-1;
+        static constexpr size_t kMinCapacity = 256;
+
+        bytebuffer() noexcept = default;
+        explicit bytebuffer(size_t capacity)
+            : m_data(std::make_unique<char[]>(capacity))
+            , m_capacity(capacity) {}
+        bytebuffer(const bytebuffer&)                = delete;
+        bytebuffer& operator=(const bytebuffer&)     = delete;
+        bytebuffer(bytebuffer&&) noexcept            = default;
+        bytebuffer& operator=(bytebuffer&&) noexcept = default;
+
+        const char* data() const noexcept {
+            return m_data.get() + m_rpos;
+        }
+        size_t size() const noexcept {
+            return m_wpos - m_rpos;
+        }
+        bool empty() const noexcept {
+            return m_wpos == m_rpos;
+        }
+        size_t capacity() const noexcept {
+            return m_capacity;
+        }
+        std::string_view view() const noexcept {
+            return { data(), size() };
+        }
+        // Returns at least n writable bytes after the write cursor, compacting
+        // or growing the storage if needed. Call commit() with the bytes used.
+        char* prepare(size_t n) {
+            if (m_capacity - m_wpos < n) {
+                if (m_capacity - size() >= n) {
+                    compact();
+                }
+                else {
+                    size_t newcap = m_capacity < kMinCapacity ? kMinCapacity : m_capacity;
+                    while (newcap - size() < n) {
+                        newcap *= 2;
+                    }
+                    auto newdata = std::make_unique<char[]>(newcap);
+                    if (!empty()) {
+                        memcpy(newdata.get(), data(), size());
+                    }
+                    m_wpos     = size();
+                    m_rpos     = 0;
+                    m_data     = std::move(newdata);
+                    m_capacity = newcap;
+                }
+            }
+            return m_data.get() + m_wpos;
+        }
+        void commit(size_t n) noexcept {
+            m_wpos += n;
+        }
+        void append(const char* buf, size_t n) {
+            memcpy(prepare(n), buf, n);
+            commit(n);
+        }
+        void consume(size_t n) noexcept {
+            if (n >= size()) {
+                clear();
+                return;
+            }
+            m_rpos += n;
+        }
+        size_t find(std::string_view delim, size_t from = 0) const noexcept {
+            if (from > size()) {
+                return npos;
+            }
+            size_t pos = view().find(delim, from);
+            return pos == std::string_view::npos ? npos : pos;
+        }
+        void compact() noexcept {
+            if (m_rpos == 0) {
+                return;
+            }
+            if (!empty()) {
+                memmove(m_data.get(), data(), size());
+            }
+            m_wpos -= m_rpos;
+            m_rpos = 0;
+        }
+        void clear() noexcept {
+            m_rpos = 0;
+            m_wpos = 0;
+        }
+
+    private:
+        std::unique_ptr<char[]> m_data;
+        size_t m_capacity = 0;
+        size_t m_rpos     = 0;
+        size_t m_wpos     = 0;
+    };
+}
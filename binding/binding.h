@@ -243,6 +243,22 @@ namespace bee::lua {
         lua_pop(L, 1);
         return 0;
     }
+
+    // pushes a bee.socket object that takes ownership of fd, the way other
+    // modules hand out a selectable duplicate of a descriptor they keep.
+    // Returns false, leaving fd to the caller, if bee.socket is not built in.
+    inline bool pushsocket(lua_State* L, intptr_t fd) {
+        auto it = usermodules::v.find("bee.socket");
+        if (it == usermodules::v.end()) {
+            return false;
+        }
+        luaL_requiref(L, "bee.socket", it->second, 0);
+        lua_getfield(L, -1, "fd");
+        lua_remove(L, -2);
+        lua_pushlightuserdata(L, (void*)fd);
+        lua_call(L, 1, 1);
+        return true;
+    }
 }
 
 #if !defined(BEE_STATIC)
@@ -4,10 +4,15 @@
 #include <bee/nonstd/unreachable.h>
 #include <binding/binding.h>
 
+#if !defined(_WIN32)
+#    include <fcntl.h>
+#    include <unistd.h>
+#endif
+
 namespace bee::lua {
     template <>
     struct udata<filewatch::watch> {
-        static inline int nupvalue = 1;
+        static inline int nupvalue = 2;
         static inline auto name    = "bee::filewatch";
     };
 }
@@ -57,9 +62,27 @@ namespace bee::lua_filewatch {
         filewatch::watch& self = to(L, 1);
         if (lua_isnoneornil(L, 2)) {
             bool ok = self.set_filter();
+            self.set_rules({});
+            lua_pushboolean(L, ok);
+            return 1;
+        }
+        if (lua_type(L, 2) == LUA_TTABLE) {
+            // gitignore-style rules, matched without calling back into Lua.
+            std::vector<std::string> rules;
+            lua_Integer n = luaL_len(L, 2);
+            for (lua_Integer i = 1; i <= n; ++i) {
+                lua_geti(L, 2, i);
+                auto rule = lua::checkstrview(L, -1);
+                rules.emplace_back(rule.data(), rule.size());
+                lua_pop(L, 1);
+            }
+            self.set_filter();
+            bool ok = self.set_rules(rules);
             lua_pushboolean(L, ok);
             return 1;
         }
+        luaL_checktype(L, 2, LUA_TFUNCTION);
+        self.set_rules({});
         lua_State* thread = get_thread(L);
         lua_settop(L, 2);
         lua_xmove(L, thread, 1);
@@ -81,27 +104,124 @@ namespace bee::lua_filewatch {
         return 1;
     }
 
-    static int select(lua_State* L) {
+    static int set_rescan(lua_State* L) {
         filewatch::watch& self = to(L, 1);
-        self.update();
-        auto notify = self.select();
-        if (!notify) {
-            return 0;
-        }
-        switch (notify->flags) {
+        bool enable            = lua_toboolean(L, 2);
+        bool ok                = self.set_rescan(enable);
+        lua_pushboolean(L, ok);
+        return 1;
+    }
+
+    static int set_quiet_period(lua_State* L) {
+        filewatch::watch& self = to(L, 1);
+        lua_Number sec         = luaL_checknumber(L, 2);
+        lua_Number maxwait     = luaL_optnumber(L, 3, sec * 10);
+        luaL_argcheck(L, sec >= 0, 2, "out of range");
+        luaL_argcheck(L, maxwait >= sec, 3, "out of range");
+        self.set_quiet_period((uint64_t)(sec * 1000), (uint64_t)(maxwait * 1000));
+        lua_pushboolean(L, 1);
+        return 1;
+    }
+
+    static int set_queue_limit(lua_State* L) {
+        filewatch::watch& self = to(L, 1);
+        self.set_queue_limit(lua::checkinteger<size_t>(L, 2));
+        lua_pushboolean(L, 1);
+        return 1;
+    }
+
+    static void push_flag(lua_State* L, filewatch::notify::flag flag) {
+        switch (flag) {
         case filewatch::notify::flag::modify:
             lua_pushstring(L, "modify");
             break;
         case filewatch::notify::flag::rename:
             lua_pushstring(L, "rename");
             break;
+        case filewatch::notify::flag::overflow:
+            lua_pushstring(L, "overflow");
+            break;
         default:
             std::unreachable();
         }
+    }
+
+    static int select(lua_State* L) {
+        filewatch::watch& self = to(L, 1);
+        self.update();
+        auto notify = self.select();
+        if (!notify) {
+            return 0;
+        }
+        push_flag(L, notify->flags);
         lua_pushlstring(L, notify->path.data(), notify->path.size());
         return 2;
     }
 
+    static int select_many(lua_State* L) {
+        filewatch::watch& self = to(L, 1);
+        auto max               = lua::optinteger<lua_Integer, LUA_MAXINTEGER>(L, 2);
+        luaL_argcheck(L, max > 0, 2, "out of range");
+        self.update();
+        lua_newtable(L);
+        lua_newtable(L);
+        for (lua_Integer n = 1; n <= max; ++n) {
+            auto notify = self.select();
+            if (!notify) {
+                break;
+            }
+            push_flag(L, notify->flags);
+            lua_rawseti(L, -3, n);
+            lua_pushlstring(L, notify->path.data(), notify->path.size());
+            lua_rawseti(L, -2, n);
+        }
+        return 2;
+    }
+
+    static int wait(lua_State* L) {
+        filewatch::watch& self = to(L, 1);
+        lua_Number timeo       = luaL_optnumber(L, 2, -1);
+        lua_pushboolean(L, self.wait(timeo < 0 ? -1 : (int)(timeo * 1000)));
+        return 1;
+    }
+
+    static int fd(lua_State* L) {
+        filewatch::watch& self = to(L, 1);
+        if (LUA_TUSERDATA == lua_getiuservalue(L, 1, 2)) {
+            return 1;
+        }
+        lua_pop(L, 1);
+#if defined(_WIN32)
+        (void)self;
+        return 0;
+#else
+        int fd = self.fd();
+        if (fd == -1) {
+            return 0;
+        }
+        // a socket object owning a dup, so closing it leaves the watch intact.
+        int dupfd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        if (dupfd == -1) {
+            lua_pushnil(L);
+            lua_pushstring(L, make_syserror("dup").c_str());
+            return 2;
+        }
+        if (!lua::pushsocket(L, dupfd)) {
+            ::close(dupfd);
+            return 0;
+        }
+        lua_pushvalue(L, -1);
+        lua_setiuservalue(L, 1, 2);
+        return 1;
+#endif
+    }
+
+    static int type(lua_State* L) {
+        filewatch::watch& self = to(L, 1);
+        lua_pushstring(L, self.backend());
+        return 1;
+    }
+
     static int mt_close(lua_State* L) {
         filewatch::watch& self = to(L, 1);
         self.stop();
@@ -114,7 +234,14 @@ namespace bee::lua_filewatch {
             { "set_recursive", set_recursive },
             { "set_follow_symlinks", set_follow_symlinks },
             { "set_filter", set_filter },
+            { "set_rescan", set_rescan },
+            { "set_quiet_period", set_quiet_period },
+            { "set_queue_limit", set_queue_limit },
             { "select", select },
+            { "select_many", select_many },
+            { "wait", wait },
+            { "fd", fd },
+            { "type", type },
             { NULL, NULL }
         };
         luaL_newlibtable(L, lib);
@@ -128,7 +255,13 @@ namespace bee::lua_filewatch {
     }
 
     static int create(lua_State* L) {
-        lua::newudata<filewatch::watch>(L, metatable);
+        static const char* const backends[] = { "default", "fanotify", NULL };
+        int backend                          = luaL_checkoption(L, 1, "default", backends);
+        auto& self                           = lua::newudata<filewatch::watch>(L, metatable);
+        if (backend == 1) {
+            // falls back to the default backend; fw:type() tells which one is active.
+            self.use_fanotify();
+        }
         lua_newthread(L);
         lua_setiuservalue(L, -2, 1);
         return 1;
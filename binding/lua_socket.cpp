@@ -5,16 +5,76 @@
 #    include <sys/select.h>
 #endif
 #include <bee/error.h>
+#include <bee/net/conntable.h>
 #include <bee/net/endpoint.h>
+#include <bee/net/pool.h>
+#include <bee/net/resolver.h>
 #include <bee/net/socket.h>
 #include <bee/nonstd/unreachable.h>
 #include <bee/thread/simplethread.h>
+#include <bee/time/monotonic.h>
+#include <bee/time/timer_wheel.h>
+#include <bee/utility/dynarray.h>
+#include <binding/udata.h>
+#if defined(__linux__)
+#    include <bee/net/uring.h>
+#endif
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace bee::lua_socket::framer {
+    enum class header : uint8_t {
+        u16be,
+        u16le,
+        u32be,
+        u32le,
+        delimiter,
+    };
+    struct state {
+        header kind = header::u32be;
+        std::string delim;
+        size_t max  = 0;
+        bytebuffer in;
+        bytebuffer out;
+        // an oversized frame is dropped as it arrives, so the stream stays in
+        // sync: skip counts its remaining bytes, or skip_delim drops up to the
+        // next delimiter.
+        size_t skip     = 0;
+        bool skip_delim = false;
+    };
+}
 
 namespace bee::lua {
     template <>
     struct udata<net::fd_t> {
         static inline auto name = "bee::net::fd";
     };
+    template <>
+    struct udata<net::resolver> {
+        static inline int nupvalue = 1;
+        static inline auto name    = "bee::net::resolver";
+    };
+    template <>
+    struct udata<net::connection_pool> {
+        static inline auto name = "bee::net::pool";
+    };
+    template <>
+    struct udata<net::conntable> {
+        static inline auto name = "bee::net::conntable";
+    };
+    template <>
+    struct udata<timer_wheel> {
+        static inline int nupvalue = 1;
+        static inline auto name    = "bee::net::timer";
+    };
+    template <>
+    struct udata<lua_socket::framer::state> {
+        static inline int nupvalue = 1;
+        static inline auto name    = "bee::net::framer";
+    };
 }
 
 namespace bee::lua_socket {
@@ -59,6 +119,66 @@ namespace bee::lua_socket {
         pushfd(L, newfd);
         return 1;
     }
+    static constexpr int kMaxAcceptBatch = 1024;
+    static int checkbatch(lua_State* L, int idx) {
+        auto max = lua::optinteger<int, 64>(L, idx);
+        luaL_argcheck(L, max > 0 && max <= kMaxAcceptBatch, idx, "out of range");
+        return max;
+    }
+    // accepts up to max pending connections, handing each to f(n, newfd, peer)
+    // with n counting from 1. Returns the count, or -1 if the first accept failed.
+    template <typename F>
+    static int accept_batch(net::fd_t fd, int max, bool with_addr, F&& f) {
+        int n = 0;
+        while (n < max) {
+            net::fd_t newfd;
+            net::socket::fdstat stat;
+            std::optional<net::endpoint_buf> peer;
+            if (with_addr) {
+                peer.emplace(sizeof(net::socket::datagram::addr));
+                stat = net::socket::accept(fd, newfd, *peer);
+            }
+            else {
+                stat = net::socket::accept(fd, newfd);
+            }
+            if (stat == net::socket::fdstat::wait) {
+                break;
+            }
+            if (stat == net::socket::fdstat::failed) {
+                // report the connections we already own; the error resurfaces next call.
+                return n > 0 ? n : -1;
+            }
+            f(++n, newfd, peer);
+        }
+        return n;
+    }
+    static int accept_many(lua_State* L) {
+        auto fd        = checkfd(L, 1);
+        auto max       = checkbatch(L, 2);
+        bool with_addr = lua_toboolean(L, 3);
+        lua_settop(L, 3);
+        lua_newtable(L);
+        if (with_addr) {
+            lua_newtable(L);
+        }
+        int n = accept_batch(fd, max, with_addr, [&](int i, net::fd_t newfd, std::optional<net::endpoint_buf>& peer) {
+            pushfd(L, newfd);
+            lua_rawseti(L, 4, i);
+            if (peer) {
+                auto ep = net::endpoint::from_buf(std::move(*peer));
+                lua_pushlstring(L, (const char*)ep.addr(), (size_t)ep.addrlen());
+                lua_rawseti(L, 5, i);
+            }
+        });
+        if (n < 0) {
+            return push_neterror(L, "accept");
+        }
+        if (n == 0) {
+            lua_pushboolean(L, 0);
+            return 1;
+        }
+        return with_addr ? 2 : 1;
+    }
     static int recv(lua_State* L) {
         auto fd  = checkfd(L, 1);
         auto len = lua::optinteger<int, LUAL_BUFFERSIZE>(L, 2);
@@ -82,6 +202,29 @@ namespace bee::lua_socket {
             std::unreachable();
         }
     }
+    static int recv_into(lua_State* L) {
+        auto fd   = checkfd(L, 1);
+        auto& buf = lua::checkudata<bytebuffer>(L, 2);
+        auto len  = lua::optinteger<int, LUAL_BUFFERSIZE>(L, 3);
+        luaL_argcheck(L, len > 0, 3, "must be positive");
+        int rc;
+        switch (net::socket::recv(fd, rc, buf.prepare((size_t)len), len)) {
+        case net::socket::status::close:
+            lua_pushnil(L);
+            return 1;
+        case net::socket::status::wait:
+            lua_pushboolean(L, 0);
+            return 1;
+        case net::socket::status::success:
+            buf.commit((size_t)rc);
+            lua_pushinteger(L, rc);
+            return 1;
+        case net::socket::status::failed:
+            return push_neterror(L, "recv");
+        default:
+            std::unreachable();
+        }
+    }
     static int send(lua_State* L) {
         auto fd  = checkfd(L, 1);
         auto buf = lua::checkstrview(L, 2);
@@ -99,6 +242,200 @@ namespace bee::lua_socket {
             std::unreachable();
         }
     }
+    static constexpr lua_Integer kMaxIobuf = 1024;
+    static int recvv(lua_State* L) {
+        auto fd = checkfd(L, 1);
+        luaL_checktype(L, 2, LUA_TTABLE);
+        lua_Integer n = luaL_len(L, 2);
+        luaL_argcheck(L, n > 0 && n <= kMaxIobuf, 2, "invalid number of buffers");
+        dynarray<net::socket::iobuf> bufs((size_t)n);
+        size_t total = 0;
+        for (lua_Integer i = 0; i < n; ++i) {
+            lua_rawgeti(L, 2, i + 1);
+            auto len = lua::checkinteger<int>(L, -1);
+            lua_pop(L, 1);
+            luaL_argcheck(L, len > 0, 2, "buffer size must be positive");
+            bufs[i].len = len;
+            total += (size_t)len;
+        }
+        dynarray<char> storage(total);
+        char* p = storage.data();
+        for (auto& buf : bufs) {
+            buf.buf = p;
+            p += buf.len;
+        }
+        int rc;
+        switch (net::socket::recvv(fd, rc, bufs.data(), (int)n)) {
+        case net::socket::status::close:
+            lua_pushnil(L);
+            return 1;
+        case net::socket::status::wait:
+            lua_pushboolean(L, 0);
+            return 1;
+        case net::socket::status::success: {
+            lua_createtable(L, (int)n, 0);
+            size_t remain = (size_t)rc;
+            for (lua_Integer i = 0; i < n && remain > 0; ++i) {
+                size_t len = (std::min)((size_t)bufs[i].len, remain);
+                lua_pushlstring(L, bufs[i].buf, len);
+                lua_rawseti(L, -2, i + 1);
+                remain -= len;
+            }
+            return 1;
+        }
+        case net::socket::status::failed:
+            return push_neterror(L, "recvv");
+        default:
+            std::unreachable();
+        }
+    }
+    static int sendv(lua_State* L) {
+        auto fd = checkfd(L, 1);
+        luaL_checktype(L, 2, LUA_TTABLE);
+        lua_Integer n = luaL_len(L, 2);
+        luaL_argcheck(L, n > 0 && n <= kMaxIobuf, 2, "invalid number of buffers");
+        dynarray<net::socket::iobuf> bufs((size_t)n);
+        for (lua_Integer i = 0; i < n; ++i) {
+            lua_rawgeti(L, 2, i + 1);
+            auto str    = lua::checkstrview(L, -1);
+            bufs[i].buf = const_cast<char*>(str.data());
+            bufs[i].len = (decltype(bufs[i].len))str.size();
+            lua_pop(L, 1);
+        }
+        int rc;
+        switch (net::socket::sendv(fd, rc, bufs.data(), (int)n)) {
+        case net::socket::status::wait:
+            lua_pushboolean(L, 0);
+            return 1;
+        case net::socket::status::success:
+            lua_pushinteger(L, rc);
+            return 1;
+        case net::socket::status::failed:
+            return push_neterror(L, "sendv");
+        default:
+            std::unreachable();
+        }
+    }
+    static int sendfd(lua_State* L) {
+        auto fd   = checkfd(L, 1);
+        auto pass = checkfd(L, 2);
+        auto data = lua::checkstrview(L, 3);
+        luaL_argcheck(L, !data.empty(), 3, "the fd needs a non-empty payload to travel with");
+        int rc;
+        switch (net::socket::sendfd(fd, rc, pass, data.data(), (int)data.size())) {
+        case net::socket::status::wait:
+            lua_pushboolean(L, 0);
+            return 1;
+        case net::socket::status::success:
+            lua_pushinteger(L, rc);
+            return 1;
+        case net::socket::status::failed:
+            return push_neterror(L, "sendfd");
+        default:
+            std::unreachable();
+        }
+    }
+    static int recvfd(lua_State* L) {
+        auto fd  = checkfd(L, 1);
+        auto len = lua::optinteger<int, LUAL_BUFFERSIZE>(L, 2);
+        luaL_Buffer b;
+        luaL_buffinit(L, &b);
+        auto buf = luaL_prepbuffsize(&b, (size_t)len);
+        int rc;
+        net::fd_t newfd;
+        switch (net::socket::recvfd(fd, rc, newfd, buf, len)) {
+        case net::socket::status::close:
+            lua_pushnil(L);
+            return 1;
+        case net::socket::status::wait:
+            lua_pushboolean(L, 0);
+            return 1;
+        case net::socket::status::success:
+            luaL_addsize(&b, rc);
+            luaL_pushresult(&b);
+            if (newfd == net::retired_fd) {
+                return 1;
+            }
+            pushfd(L, newfd);
+            return 2;
+        case net::socket::status::failed:
+            return push_neterror(L, "recvfd");
+        default:
+            std::unreachable();
+        }
+    }
+    static int peercred(lua_State* L) {
+        auto fd = checkfd(L, 1);
+        net::socket::credential cred;
+        if (!net::socket::peercred(fd, cred)) {
+            return push_neterror(L, "peercred");
+        }
+        lua_createtable(L, 0, 3);
+        if (cred.pid >= 0) {
+            lua_pushinteger(L, cred.pid);
+            lua_setfield(L, -2, "pid");
+        }
+        lua_pushinteger(L, cred.uid);
+        lua_setfield(L, -2, "uid");
+        lua_pushinteger(L, cred.gid);
+        lua_setfield(L, -2, "gid");
+        return 1;
+    }
+    static void push_counters(lua_State* L, const net::socket::counters& c) {
+        lua_createtable(L, 0, 8);
+        lua_pushinteger(L, (lua_Integer)c.bytes_in);
+        lua_setfield(L, -2, "bytes_in");
+        lua_pushinteger(L, (lua_Integer)c.bytes_out);
+        lua_setfield(L, -2, "bytes_out");
+        lua_pushinteger(L, (lua_Integer)c.syscalls);
+        lua_setfield(L, -2, "syscalls");
+        lua_pushinteger(L, (lua_Integer)c.wait_in);
+        lua_setfield(L, -2, "wait_in");
+        lua_pushinteger(L, (lua_Integer)c.wait_out);
+        lua_setfield(L, -2, "wait_out");
+        lua_pushinteger(L, (lua_Integer)c.partial_writes);
+        lua_setfield(L, -2, "partial_writes");
+        lua_pushinteger(L, (lua_Integer)c.connects);
+        lua_setfield(L, -2, "connects");
+        lua_pushinteger(L, (lua_Integer)c.connect_time);
+        lua_setfield(L, -2, "connect_time");
+    }
+    static int fd_stats(lua_State* L) {
+        auto fd = checkfd(L, 1);
+        net::socket::counters c;
+        if (!net::socket::fd_stats(fd, c)) {
+            return 0;
+        }
+        push_counters(L, c);
+        return 1;
+    }
+    static int tcpinfo(lua_State* L) {
+        auto fd = checkfd(L, 1);
+        net::socket::tcpinfo info;
+        if (!net::socket::tcp_stats(fd, info)) {
+            return push_neterror(L, "tcpinfo");
+        }
+        lua_createtable(L, 0, 9);
+        lua_pushinteger(L, info.rtt);
+        lua_setfield(L, -2, "rtt");
+        lua_pushinteger(L, info.rttvar);
+        lua_setfield(L, -2, "rttvar");
+        lua_pushinteger(L, info.retransmits);
+        lua_setfield(L, -2, "retransmits");
+        lua_pushinteger(L, info.total_retrans);
+        lua_setfield(L, -2, "total_retrans");
+        lua_pushinteger(L, info.lost);
+        lua_setfield(L, -2, "lost");
+        lua_pushinteger(L, info.unacked);
+        lua_setfield(L, -2, "unacked");
+        lua_pushinteger(L, info.snd_cwnd);
+        lua_setfield(L, -2, "snd_cwnd");
+        lua_pushinteger(L, info.snd_mss);
+        lua_setfield(L, -2, "snd_mss");
+        lua_pushinteger(L, info.rcv_space);
+        lua_setfield(L, -2, "rcv_space");
+        return 1;
+    }
     static int recvfrom(lua_State* L) {
         auto fd  = checkfd(L, 1);
         auto len = lua::optinteger<int, LUAL_BUFFERSIZE>(L, 2);
@@ -151,6 +488,149 @@ namespace bee::lua_socket {
             std::unreachable();
         }
     }
+    static constexpr int kMaxDatagramBatch    = 64;
+    static constexpr int kDefaultDatagramSize = 2048;
+    static int recvmmsg(lua_State* L) {
+        auto fd   = checkfd(L, 1);
+        auto n    = lua::optinteger<int, kMaxDatagramBatch>(L, 2);
+        auto size = lua::optinteger<int, kDefaultDatagramSize>(L, 3);
+        luaL_argcheck(L, n > 0 && n <= kMaxDatagramBatch, 2, "out of range");
+        luaL_argcheck(L, size > 0, 3, "must be positive");
+        dynarray<char> storage((size_t)n * (size_t)size);
+        dynarray<net::socket::datagram> msgs((size_t)n);
+        for (int i = 0; i < n; ++i) {
+            msgs[i].buf.buf = storage.data() + (size_t)i * (size_t)size;
+            msgs[i].buf.len = size;
+        }
+        int rc;
+        switch (net::socket::recvmmsg(fd, rc, msgs.data(), n)) {
+        case net::socket::status::wait:
+            lua_pushboolean(L, 0);
+            return 1;
+        case net::socket::status::success:
+            lua_createtable(L, rc, 0);
+            lua_createtable(L, rc, 0);
+            for (int i = 0; i < rc; ++i) {
+                lua_pushlstring(L, msgs[i].buf.buf, (size_t)msgs[i].len);
+                lua_rawseti(L, -3, i + 1);
+                lua_pushlstring(L, (const char*)msgs[i].addr, (size_t)msgs[i].addrlen);
+                lua_rawseti(L, -2, i + 1);
+            }
+            return 2;
+        case net::socket::status::failed:
+            return push_neterror(L, "recvmmsg");
+        default:
+            std::unreachable();
+        }
+    }
+    static int sendmmsg(lua_State* L) {
+        auto fd = checkfd(L, 1);
+        luaL_checktype(L, 2, LUA_TTABLE);
+        lua_Integer n = luaL_len(L, 2);
+        luaL_argcheck(L, n > 0, 2, "empty batch");
+        if (n > kMaxDatagramBatch) {
+            n = kMaxDatagramBatch;
+        }
+        dynarray<net::socket::datagram> msgs((size_t)n);
+        for (lua_Integer i = 0; i < n; ++i) {
+            if (LUA_TTABLE != lua_rawgeti(L, 2, i + 1)) {
+                return luaL_argerror(L, 2, "datagram must be a table");
+            }
+            lua_rawgeti(L, -1, 1);
+            auto data = lua::checkstrview(L, -1);
+            lua_rawgeti(L, -2, 2);
+            auto addr = lua::checkstrview(L, -1);
+            if (addr.size() > sizeof(msgs[i].addr)) {
+                return luaL_argerror(L, 2, "invalid endpoint");
+            }
+            msgs[i].buf.buf = const_cast<char*>(data.data());
+            msgs[i].buf.len = (decltype(msgs[i].buf.len))data.size();
+            msgs[i].addrlen = (int)addr.size();
+            memcpy(msgs[i].addr, addr.data(), addr.size());
+            // the strings stay referenced by the batch table during the call.
+            lua_pop(L, 3);
+        }
+        int rc;
+        switch (net::socket::sendmmsg(fd, rc, msgs.data(), (int)n)) {
+        case net::socket::status::wait:
+            lua_pushboolean(L, 0);
+            return 1;
+        case net::socket::status::success:
+            lua_pushinteger(L, rc);
+            return 1;
+        case net::socket::status::failed:
+            return push_neterror(L, "sendmmsg");
+        default:
+            std::unreachable();
+        }
+    }
+    static int sendfile(lua_State* L) {
+        auto fd     = checkfd(L, 1);
+        auto offset = lua::optinteger<int64_t, 0>(L, 3);
+        auto len    = lua::optinteger<int, (std::numeric_limits<int>::max)()>(L, 4);
+        luaL_argcheck(L, offset >= 0, 3, "must be non-negative");
+        luaL_argcheck(L, len >= 0, 4, "must be non-negative");
+        FILE* owned = NULL;
+        FILE* f     = NULL;
+        if (lua_type(L, 2) == LUA_TSTRING) {
+            owned = fopen(lua_tostring(L, 2), "rb");
+            if (!owned) {
+                lua_pushnil(L);
+                lua_pushstring(L, make_crterror("fopen").c_str());
+                return 2;
+            }
+            f = owned;
+        }
+        else {
+            auto p = (luaL_Stream*)luaL_testudata(L, 2, "bee::file");
+            if (!p) {
+                p = (luaL_Stream*)luaL_checkudata(L, 2, LUA_FILEHANDLE);
+            }
+            luaL_argcheck(L, p->closef != NULL, 2, "attempt to use a closed file");
+            f = p->f;
+        }
+        int rc;
+        auto status = net::socket::sendfile(fd, rc, file_handle::from_file(f).value(), offset, len);
+        if (owned) {
+            int saved = errno;
+            fclose(owned);
+            errno = saved;
+        }
+        switch (status) {
+        case net::socket::status::wait:
+            lua_pushboolean(L, 0);
+            return 1;
+        case net::socket::status::success:
+            lua_pushinteger(L, rc);
+            return 1;
+        case net::socket::status::failed:
+            return push_neterror(L, "sendfile");
+        default:
+            std::unreachable();
+        }
+    }
+    static int splice(lua_State* L) {
+        auto from = checkfd(L, 1);
+        auto to   = checkfd(L, 2);
+        auto len  = lua::optinteger<int, 64 * 1024>(L, 3);
+        luaL_argcheck(L, len > 0, 3, "must be positive");
+        int rc;
+        switch (net::socket::splice(from, to, rc, len)) {
+        case net::socket::status::close:
+            lua_pushnil(L);
+            return 1;
+        case net::socket::status::wait:
+            lua_pushboolean(L, 0);
+            return 1;
+        case net::socket::status::success:
+            lua_pushinteger(L, rc);
+            return 1;
+        case net::socket::status::failed:
+            return push_neterror(L, "splice");
+        default:
+            std::unreachable();
+        }
+    }
     static bool socket_destroy(lua_State* L) {
         auto& fd = lua::checkudata<net::fd_t>(L, 1);
         if (fd == net::retired_fd) {
@@ -257,22 +737,48 @@ namespace bee::lua_socket {
             luaL_error(L, "socket is already closed.");
             return 0;
         }
+        net::socket::forget_stats(fd);
         lua_pushlightuserdata(L, (void*)(intptr_t)fd);
         fd = net::retired_fd;
         return 1;
     }
+    static net::socket::option checkoption(lua_State* L, int idx) {
+        static const char* const opts[] = {
+            "reuseaddr", "sndbuf", "rcvbuf", "reuseport",
+            "keepalive", "keepidle", "keepintvl", "keepcnt",
+            "nodelay", "cork", "quickack", "busypoll",
+            "fastopen", "tos",
+            NULL
+        };
+        return (net::socket::option)luaL_checkoption(L, idx, NULL, opts);
+    }
     static int option(lua_State* L) {
-        auto fd                         = checkfd(L, 1);
-        static const char* const opts[] = { "reuseaddr", "sndbuf", "rcvbuf", NULL };
-        auto opt                        = (net::socket::option)luaL_checkoption(L, 2, NULL, opts);
-        auto value                      = lua::checkinteger<int>(L, 3);
-        bool ok                         = net::socket::setoption(fd, opt, value);
+        auto fd  = checkfd(L, 1);
+        auto opt = checkoption(L, 2);
+        int value;
+        if (lua_type(L, 3) == LUA_TBOOLEAN) {
+            value = lua_toboolean(L, 3);
+        }
+        else {
+            value = lua::checkinteger<int>(L, 3);
+        }
+        bool ok = net::socket::setoption(fd, opt, value);
         if (!ok) {
             return push_neterror(L, "setsockopt");
         }
         lua_pushboolean(L, 1);
         return 1;
     }
+    static int getoption(lua_State* L) {
+        auto fd   = checkfd(L, 1);
+        auto opt  = checkoption(L, 2);
+        int value = 0;
+        if (!net::socket::getoption(fd, opt, value)) {
+            return push_neterror(L, "getsockopt");
+        }
+        lua_pushinteger(L, value);
+        return 1;
+    }
     static int connect(lua_State* L) {
         auto fd = checkfd(L, 1);
         auto ep = read_endpoint(L, 2);
@@ -315,10 +821,23 @@ namespace bee::lua_socket {
             { "bind", bind },
             { "listen", listen },
             { "accept", accept },
+            { "accept_many", accept_many },
+            { "sendfd", sendfd },
+            { "recvfd", recvfd },
+            { "peercred", peercred },
+            { "stats", fd_stats },
+            { "tcpinfo", tcpinfo },
             { "recv", recv },
+            { "recv_into", recv_into },
             { "send", send },
+            { "recvv", recvv },
+            { "sendv", sendv },
             { "recvfrom", recvfrom },
             { "sendto", sendto },
+            { "recvmmsg", recvmmsg },
+            { "sendmmsg", sendmmsg },
+            { "sendfile", sendfile },
+            { "splice", splice },
             { "close", close },
             { "shutdown", shutdown },
             { "status", status },
@@ -326,6 +845,7 @@ namespace bee::lua_socket {
             { "handle", handle },
             { "detach", detach },
             { "option", option },
+            { "getoption", getoption },
             { NULL, NULL },
         };
         luaL_newlibtable(L, lib);
@@ -351,11 +871,52 @@ namespace bee::lua_socket {
         pushfd(L, sv[1]);
         return 2;
     }
+    static int pipe(lua_State* L) {
+#if defined(_WIN32)
+        // anonymous pipes on windows are neither non-blocking nor selectable.
+        auto error = make_error(std::make_error_code(std::errc::function_not_supported), "pipe");
+        lua_pushnil(L);
+        lua_pushstring(L, error.c_str());
+        return 2;
+#else
+        net::fd_t sv[2];
+        if (!net::socket::pipe(sv)) {
+            return push_neterror(L, "pipe");
+        }
+        pushfd(L, sv[0]);
+        pushfd(L, sv[1]);
+        return 2;
+#endif
+    }
     static int fd(lua_State* L) {
         auto fd = lua::checklightud<net::fd_t>(L, 1);
         pushfd(L, fd);
         return 1;
     }
+    static int endpoint(lua_State* L) {
+        auto ep = read_endpoint(L, 1);
+        lua_pushlstring(L, (const char*)ep.addr(), (size_t)ep.addrlen());
+        return 1;
+    }
+    static int endpoint_info(lua_State* L) {
+        auto addr = lua::checkstrview(L, 1);
+        luaL_argcheck(L, addr.size() >= sizeof(unsigned short), 1, "invalid endpoint");
+        net::endpoint_buf buf(addr.size());
+        memcpy(buf.addr(), addr.data(), addr.size());
+        auto ep         = net::endpoint::from_buf(std::move(buf));
+        auto [ip, port] = ep.info();
+        lua_pushlstring(L, ip.data(), ip.size());
+        lua_pushinteger(L, port);
+        return 2;
+    }
+    static int stats(lua_State* L) {
+        if (!lua_isnoneornil(L, 1)) {
+            luaL_checktype(L, 1, LUA_TBOOLEAN);
+            net::socket::track_stats(lua_toboolean(L, 1));
+        }
+        push_counters(L, net::socket::global_stats());
+        return 1;
+    }
     static int mt_call(lua_State* L) {
         static const char* const opts[] = {
             "tcp", "udp", "unix", "tcp6", "udp6",
@@ -369,6 +930,1659 @@ namespace bee::lua_socket {
         pushfd(L, fd);
         return 1;
     }
+    static int listen_group(lua_State* L) {
+        static const char* const opts[] = {
+            "tcp", "udp", "unix", "tcp6", "udp6",
+            NULL
+        };
+        auto protocol = (net::socket::protocol)luaL_checkoption(L, 1, NULL, opts);
+        luaL_argcheck(L, protocol != net::socket::protocol::unix, 1, "unix sockets cannot share a port");
+        auto ip      = lua::checkstrview(L, 2);
+        auto port    = lua::checkinteger<uint16_t>(L, 3);
+        auto n       = lua::checkinteger<int>(L, 4);
+        auto backlog = lua::optinteger<int, 128>(L, 5);
+        luaL_argcheck(L, n > 0, 4, "out of range");
+        bool stream = protocol == net::socket::protocol::tcp || protocol == net::socket::protocol::tcp6;
+        auto ep     = net::endpoint::from_hostname(ip, port);
+        if (!ep.valid()) {
+            return luaL_error(L, "invalid address: %s:%d", ip.data(), port);
+        }
+        dynarray<net::fd_t> fds((size_t)n);
+        std::fill(fds.begin(), fds.end(), net::retired_fd);
+        const char* what = nullptr;
+        for (auto& fd : fds) {
+            fd = net::socket::open(protocol);
+            if (fd == net::retired_fd) {
+                what = "socket";
+                break;
+            }
+            if (!net::socket::setoption(fd, net::socket::option::reuseport, 1)) {
+                what = "setsockopt";
+                break;
+            }
+            if (!net::socket::bind(fd, ep)) {
+                what = "bind";
+                break;
+            }
+            if (stream && !net::socket::listen(fd, backlog)) {
+                what = "listen";
+                break;
+            }
+            if (port == 0) {
+                // the first bind picks an ephemeral port; the rest of the group must share it.
+                auto self = net::socket::getsockname(fd);
+                if (!self) {
+                    what = "getsockname";
+                    break;
+                }
+                port = self->info().port;
+                ep   = net::endpoint::from_hostname(ip, port);
+            }
+        }
+        if (what) {
+            auto error = make_neterror(what);
+            for (auto& fd : fds) {
+                if (fd != net::retired_fd) {
+                    net::socket::close(fd);
+                }
+            }
+            lua_pushnil(L);
+            lua_pushstring(L, error.c_str());
+            return 2;
+        }
+        lua_createtable(L, n, 0);
+        for (int i = 0; i < n; ++i) {
+            pushfd(L, fds[i]);
+            lua_rawseti(L, -2, i + 1);
+        }
+        return 1;
+    }
+    namespace buffer {
+        static bytebuffer& to(lua_State* L, int idx) {
+            return lua::checkudata<bytebuffer>(L, idx);
+        }
+        static int write(lua_State* L) {
+            auto& self = to(L, 1);
+            int n      = lua_gettop(L);
+            for (int i = 2; i <= n; ++i) {
+                auto str = lua::checkstrview(L, i);
+                self.append(str.data(), str.size());
+            }
+            lua_settop(L, 1);
+            return 1;
+        }
+        static int read(lua_State* L) {
+            auto& self = to(L, 1);
+            size_t n   = self.size();
+            if (!lua_isnoneornil(L, 2)) {
+                n = lua::checkinteger<size_t>(L, 2);
+                if (n > self.size()) {
+                    return 0;
+                }
+            }
+            lua_pushlstring(L, self.data(), n);
+            self.consume(n);
+            return 1;
+        }
+        static int peek(lua_State* L) {
+            auto& self = to(L, 1);
+            size_t n   = self.size();
+            if (!lua_isnoneornil(L, 2)) {
+                n = (std::min)(lua::checkinteger<size_t>(L, 2), self.size());
+            }
+            lua_pushlstring(L, self.data(), n);
+            return 1;
+        }
+        static int readline(lua_State* L) {
+            auto& self             = to(L, 1);
+            std::string_view delim = "\n";
+            if (!lua_isnoneornil(L, 2)) {
+                auto str = lua::checkstrview(L, 2);
+                delim    = { str.data(), str.size() };
+            }
+            bool keep  = lua_toboolean(L, 3);
+            size_t pos = self.find(delim);
+            if (pos == bytebuffer::npos) {
+                return 0;
+            }
+            lua_pushlstring(L, self.data(), keep ? pos + delim.size() : pos);
+            self.consume(pos + delim.size());
+            return 1;
+        }
+        static int find(lua_State* L) {
+            auto& self = to(L, 1);
+            auto str   = lua::checkstrview(L, 2);
+            auto init  = lua::optinteger<size_t, 1>(L, 3);
+            luaL_argcheck(L, init > 0, 3, "out of range");
+            size_t pos = self.find({ str.data(), str.size() }, init - 1);
+            if (pos == bytebuffer::npos) {
+                return 0;
+            }
+            lua_pushinteger(L, (lua_Integer)pos + 1);
+            return 1;
+        }
+        static int skip(lua_State* L) {
+            auto& self = to(L, 1);
+            auto n     = lua::checkinteger<size_t>(L, 2);
+            self.consume(n);
+            lua_settop(L, 1);
+            return 1;
+        }
+        static int compact(lua_State* L) {
+            auto& self = to(L, 1);
+            self.compact();
+            lua_settop(L, 1);
+            return 1;
+        }
+        static int clear(lua_State* L) {
+            auto& self = to(L, 1);
+            self.clear();
+            lua_settop(L, 1);
+            return 1;
+        }
+        static int mt_len(lua_State* L) {
+            auto& self = to(L, 1);
+            lua_pushinteger(L, (lua_Integer)self.size());
+            return 1;
+        }
+        static int mt_tostring(lua_State* L) {
+            auto& self = to(L, 1);
+            lua_pushfstring(L, "buffer (%d/%d)", (int)self.size(), (int)self.capacity());
+            return 1;
+        }
+        static void metatable(lua_State* L) {
+            luaL_Reg lib[] = {
+                { "write", write },
+                { "read", read },
+                { "peek", peek },
+                { "readline", readline },
+                { "find", find },
+                { "skip", skip },
+                { "compact", compact },
+                { "clear", clear },
+                { NULL, NULL },
+            };
+            luaL_newlibtable(L, lib);
+            luaL_setfuncs(L, lib, 0);
+            lua_setfield(L, -2, "__index");
+            luaL_Reg mt[] = {
+                { "__len", mt_len },
+                { "__tostring", mt_tostring },
+                { NULL, NULL },
+            };
+            luaL_setfuncs(L, mt, 0);
+        }
+        static int create(lua_State* L) {
+            auto capacity = lua::optinteger<size_t, bytebuffer::kMinCapacity>(L, 1);
+            lua::newudata<bytebuffer>(L, metatable, capacity);
+            return 1;
+        }
+    }
+    namespace resolver {
+        static net::resolver& to(lua_State* L, int idx) {
+            auto& self = lua::checkudata<net::resolver>(L, idx);
+            if (self.fd() == net::retired_fd) {
+                luaL_error(L, "resolver is already closed.");
+            }
+            return self;
+        }
+        static int query(lua_State* L) {
+            auto& self = to(L, 1);
+            auto host  = lua::checkstrview(L, 2);
+            auto port  = lua::checkinteger<uint16_t>(L, 3);
+            auto id    = self.query({ host.data(), host.size() }, port);
+            lua_pushinteger(L, (lua_Integer)id);
+            return 1;
+        }
+        static int fd(lua_State* L) {
+            auto& self = to(L, 1);
+            if (LUA_TUSERDATA == lua_getiuservalue(L, 1, 1)) {
+                return 1;
+            }
+            lua_pop(L, 1);
+            auto fd = net::socket::dup(self.fd());
+            if (fd == net::retired_fd) {
+                return push_neterror(L, "dup");
+            }
+            pushfd(L, fd);
+            lua_pushvalue(L, -1);
+            lua_setiuservalue(L, 1, 1);
+            return 1;
+        }
+        static int results(lua_State* L) {
+            auto& self = to(L, 1);
+            auto res   = self.results();
+            lua_createtable(L, (int)res.size(), 0);
+            lua_Integer n = 0;
+            for (auto& r : res) {
+                lua_createtable(L, 0, 4);
+                lua_pushinteger(L, (lua_Integer)r.id);
+                lua_setfield(L, -2, "id");
+                lua_pushlstring(L, r.host.data(), r.host.size());
+                lua_setfield(L, -2, "host");
+                if (r.addr.empty()) {
+                    lua_pushinteger(L, r.port);
+                    lua_setfield(L, -2, "port");
+                    lua_pushlstring(L, r.error.data(), r.error.size());
+                    lua_setfield(L, -2, "error");
+                }
+                else {
+                    net::endpoint_buf buf(r.addr.size());
+                    memcpy(buf.addr(), r.addr.data(), r.addr.size());
+                    auto ep         = net::endpoint::from_buf(std::move(buf));
+                    auto [ip, port] = ep.info();
+                    lua_pushlstring(L, ip.data(), ip.size());
+                    lua_setfield(L, -2, "ip");
+                    lua_pushinteger(L, port);
+                    lua_setfield(L, -2, "port");
+                    lua_pushlstring(L, r.addr.data(), r.addr.size());
+                    lua_setfield(L, -2, "addr");
+                }
+                lua_rawseti(L, -2, ++n);
+            }
+            return 1;
+        }
+        static int add_host(lua_State* L) {
+            auto& self = to(L, 1);
+            auto host  = lua::checkstrview(L, 2);
+            auto ip    = lua::checkstrview(L, 3);
+            if (!self.add_host({ host.data(), host.size() }, { ip.data(), ip.size() })) {
+                return luaL_argerror(L, 3, "numeric address expected");
+            }
+            return 0;
+        }
+        static int flush(lua_State* L) {
+            auto& self = to(L, 1);
+            self.flush_cache();
+            return 0;
+        }
+        static int close(lua_State* L) {
+            auto& self = lua::checkudata<net::resolver>(L, 1);
+            self.stop();
+            return 0;
+        }
+        static void metatable(lua_State* L) {
+            luaL_Reg lib[] = {
+                { "query", query },
+                { "fd", fd },
+                { "results", results },
+                { "add_host", add_host },
+                { "flush", flush },
+                { "close", close },
+                { NULL, NULL },
+            };
+            luaL_newlibtable(L, lib);
+            luaL_setfuncs(L, lib, 0);
+            lua_setfield(L, -2, "__index");
+            luaL_Reg mt[] = {
+                { "__close", close },
+                { NULL, NULL },
+            };
+            luaL_setfuncs(L, mt, 0);
+        }
+        static int create(lua_State* L) {
+            int threads    = 4;
+            lua_Number ttl = 60;
+            if (!lua_isnoneornil(L, 1)) {
+                luaL_checktype(L, 1, LUA_TTABLE);
+                if (LUA_TNIL != lua_getfield(L, 1, "threads")) {
+                    threads = lua::checkinteger<int>(L, -1);
+                    luaL_argcheck(L, threads > 0, 1, "threads must be positive");
+                }
+                lua_pop(L, 1);
+                if (LUA_TNIL != lua_getfield(L, 1, "ttl")) {
+                    ttl = luaL_checknumber(L, -1);
+                }
+                lua_pop(L, 1);
+            }
+            auto& self = lua::newudata<net::resolver>(L, metatable);
+            if (!lua_isnoneornil(L, 1)) {
+                if (LUA_TSTRING == lua_getfield(L, 1, "hosts")) {
+                    if (!self.load_hosts(lua_tostring(L, -1))) {
+                        lua_pushnil(L);
+                        lua_pushstring(L, make_crterror("fopen").c_str());
+                        return 2;
+                    }
+                }
+                lua_pop(L, 1);
+            }
+            auto duration = std::chrono::duration_cast<net::resolver::clock::duration>(std::chrono::duration<double>(ttl));
+            if (!self.start(threads, duration)) {
+                return push_neterror(L, "resolver");
+            }
+            return 1;
+        }
+    }
+    namespace timer {
+        static timer_wheel& to(lua_State* L, int idx) {
+            return lua::checkudata<timer_wheel>(L, idx);
+        }
+        static void getvalues(lua_State* L) {
+            lua_getiuservalue(L, 1, 1);
+        }
+        static int add(lua_State* L) {
+            auto& self = to(L, 1);
+            auto delay = lua::checkinteger<uint64_t>(L, 2);
+            auto id    = self.add(time_monotonic() + delay);
+            getvalues(L);
+            if (lua_isnoneornil(L, 3)) {
+                lua_pushboolean(L, 1);
+            }
+            else {
+                lua_pushvalue(L, 3);
+            }
+            lua_rawseti(L, -2, (lua_Integer)id);
+            lua_pushinteger(L, (lua_Integer)id);
+            return 1;
+        }
+        static int cancel(lua_State* L) {
+            auto& self = to(L, 1);
+            auto id    = (timer_wheel::timer_id)luaL_checkinteger(L, 2);
+            bool ok    = self.cancel(id);
+            if (ok) {
+                getvalues(L);
+                lua_pushnil(L);
+                lua_rawseti(L, -2, (lua_Integer)id);
+            }
+            lua_pushboolean(L, ok);
+            return 1;
+        }
+        static int reset(lua_State* L) {
+            auto& self = to(L, 1);
+            auto id    = (timer_wheel::timer_id)luaL_checkinteger(L, 2);
+            auto delay = lua::checkinteger<uint64_t>(L, 3);
+            lua_pushboolean(L, self.reset(id, time_monotonic() + delay));
+            return 1;
+        }
+        static int timeout(lua_State* L) {
+            auto& self = to(L, 1);
+            auto ms    = self.next_timeout(time_monotonic());
+            if (ms < 0) {
+                return 0;
+            }
+            lua_pushinteger(L, (lua_Integer)ms);
+            return 1;
+        }
+        static int expire(lua_State* L) {
+            auto& self = to(L, 1);
+            auto max   = lua::optinteger<size_t, (std::numeric_limits<size_t>::max)()>(L, 2);
+            std::vector<timer_wheel::timer_id> ids;
+            self.expire(time_monotonic(), ids, max);
+            lua_settop(L, 1);
+            getvalues(L);
+            lua_createtable(L, (int)ids.size(), 0);
+            lua_Integer n = 0;
+            for (auto id : ids) {
+                lua_rawgeti(L, 2, (lua_Integer)id);
+                lua_rawseti(L, 3, ++n);
+                lua_pushnil(L);
+                lua_rawseti(L, 2, (lua_Integer)id);
+            }
+            return 1;
+        }
+        static int mt_len(lua_State* L) {
+            auto& self = to(L, 1);
+            lua_pushinteger(L, (lua_Integer)self.size());
+            return 1;
+        }
+        static void metatable(lua_State* L) {
+            luaL_Reg lib[] = {
+                { "add", add },
+                { "cancel", cancel },
+                { "reset", reset },
+                { "timeout", timeout },
+                { "expire", expire },
+                { NULL, NULL },
+            };
+            luaL_newlibtable(L, lib);
+            luaL_setfuncs(L, lib, 0);
+            lua_setfield(L, -2, "__index");
+            luaL_Reg mt[] = {
+                { "__len", mt_len },
+                { NULL, NULL },
+            };
+            luaL_setfuncs(L, mt, 0);
+        }
+        static int create(lua_State* L) {
+            lua::newudata<timer_wheel>(L, metatable, time_monotonic());
+            lua_newtable(L);
+            lua_setiuservalue(L, -2, 1);
+            return 1;
+        }
+        // select() accepts a timer in place of its timeout and sleeps until the next deadline.
+        static lua_Number select_timeout(lua_State* L, int idx) {
+            if (auto self = (timer_wheel*)luaL_testudata(L, idx, lua::udata<timer_wheel>::name)) {
+                auto ms = self->next_timeout(time_monotonic());
+                return ms < 0 ? -1 : (lua_Number)ms / 1000;
+            }
+            return luaL_optnumber(L, idx, -1);
+        }
+    }
+    namespace pool {
+        static net::connection_pool& to(lua_State* L, int idx) {
+            return lua::checkudata<net::connection_pool>(L, idx);
+        }
+        static int checkout(lua_State* L) {
+            auto& self = to(L, 1);
+            auto ep    = read_endpoint(L, 2);
+            net::fd_t fd;
+            switch (self.checkout(ep, fd, time_monotonic())) {
+            case net::connection_pool::status::reused:
+                pushfd(L, fd);
+                lua_pushstring(L, "reused");
+                return 2;
+            case net::connection_pool::status::connected:
+                pushfd(L, fd);
+                lua_pushstring(L, "connected");
+                return 2;
+            case net::connection_pool::status::connecting:
+                pushfd(L, fd);
+                lua_pushstring(L, "connecting");
+                return 2;
+            case net::connection_pool::status::limit:
+                lua_pushboolean(L, 0);
+                return 1;
+            case net::connection_pool::status::failed:
+                return push_neterror(L, "connect");
+            default:
+                std::unreachable();
+            }
+        }
+        static int checkin(lua_State* L) {
+            auto& self = to(L, 1);
+            auto& fd   = lua::checkudata<net::fd_t>(L, 2);
+            bool reuse = lua_isnoneornil(L, 3) || lua_toboolean(L, 3);
+            if (fd == net::retired_fd || !self.checkin(fd, reuse, time_monotonic())) {
+                lua_pushboolean(L, 0);
+                return 1;
+            }
+            // the pool owns (or has closed) the descriptor now.
+            fd = net::retired_fd;
+            lua_pushboolean(L, 1);
+            return 1;
+        }
+        static int evict(lua_State* L) {
+            auto& self = to(L, 1);
+            lua_pushinteger(L, (lua_Integer)self.evict(time_monotonic()));
+            return 1;
+        }
+        static int stats(lua_State* L) {
+            auto& self = to(L, 1);
+            auto s     = self.get_stats();
+            lua_createtable(L, 0, 2);
+            lua_pushinteger(L, (lua_Integer)s.idle);
+            lua_setfield(L, -2, "idle");
+            lua_pushinteger(L, (lua_Integer)s.active);
+            lua_setfield(L, -2, "active");
+            return 1;
+        }
+        static int close(lua_State* L) {
+            auto& self = to(L, 1);
+            self.clear();
+            return 0;
+        }
+        static void metatable(lua_State* L) {
+            luaL_Reg lib[] = {
+                { "checkout", checkout },
+                { "checkin", checkin },
+                { "evict", evict },
+                { "stats", stats },
+                { "close", close },
+                { NULL, NULL },
+            };
+            luaL_newlibtable(L, lib);
+            luaL_setfuncs(L, lib, 0);
+            lua_setfield(L, -2, "__index");
+            luaL_Reg mt[] = {
+                { "__close", close },
+                { NULL, NULL },
+            };
+            luaL_setfuncs(L, mt, 0);
+        }
+        static int create(lua_State* L) {
+            net::connection_pool::config cfg;
+            if (!lua_isnoneornil(L, 1)) {
+                luaL_checktype(L, 1, LUA_TTABLE);
+                if (LUA_TNIL != lua_getfield(L, 1, "max")) {
+                    cfg.max_per_host = lua::checkinteger<size_t>(L, -1);
+                }
+                if (LUA_TNIL != lua_getfield(L, 1, "idle")) {
+                    cfg.max_idle = lua::checkinteger<size_t>(L, -1);
+                }
+                if (LUA_TNIL != lua_getfield(L, 1, "timeout")) {
+                    cfg.idle_timeout = lua::checkinteger<uint64_t>(L, -1);
+                }
+                lua_pop(L, 3);
+            }
+            lua::newudata<net::connection_pool>(L, metatable, cfg);
+            return 1;
+        }
+    }
+    namespace conntable {
+        static constexpr size_t kMaxSlots = 64;
+
+        static net::conntable& to(lua_State* L, int idx) {
+            return lua::checkudata<net::conntable>(L, idx);
+        }
+        static net::conntable::conn_id checkid(lua_State* L, int idx) {
+            return (net::conntable::conn_id)luaL_checkinteger(L, idx);
+        }
+        static net::conntable::conn& checkconn(lua_State* L, net::conntable& self, int idx) {
+            auto c = self.find(checkid(L, idx));
+            if (!c) {
+                luaL_argerror(L, idx, "invalid connection id");
+            }
+            return *c;
+        }
+        static int64_t& checkslot(lua_State* L, net::conntable& self) {
+            auto slots = self.slots(checkid(L, 2));
+            if (!slots) {
+                luaL_argerror(L, 2, "invalid connection id");
+            }
+            auto n = lua::checkinteger<size_t>(L, 3);
+            luaL_argcheck(L, n >= 1 && n <= self.nslots(), 3, "out of range");
+            return slots[n - 1];
+        }
+        static int push_status(lua_State* L, net::socket::status st, const char* what) {
+            switch (st) {
+            case net::socket::status::success:
+                lua_pushboolean(L, 1);
+                return 1;
+            case net::socket::status::wait:
+                lua_pushboolean(L, 0);
+                return 1;
+            case net::socket::status::failed:
+                return push_neterror(L, what);
+            default:
+                std::unreachable();
+            }
+        }
+        static int add(lua_State* L) {
+            auto& self = to(L, 1);
+            auto& fd   = lua::checkudata<net::fd_t>(L, 2);
+            if (fd == net::retired_fd) {
+                return luaL_error(L, "socket is already closed.");
+            }
+            lua_pushinteger(L, (lua_Integer)self.add(fd));
+            // the table owns the descriptor now.
+            fd = net::retired_fd;
+            return 1;
+        }
+        static int accept(lua_State* L) {
+            auto& self = to(L, 1);
+            auto fd    = checkfd(L, 2);
+            auto max   = checkbatch(L, 3);
+            lua_settop(L, 3);
+            lua_newtable(L);
+            int n = accept_batch(fd, max, false, [&](int i, net::fd_t newfd, std::optional<net::endpoint_buf>&) {
+                lua_pushinteger(L, (lua_Integer)self.add(newfd));
+                lua_rawseti(L, 4, i);
+            });
+            if (n < 0) {
+                return push_neterror(L, "accept");
+            }
+            if (n == 0) {
+                lua_pushboolean(L, 0);
+            }
+            return 1;
+        }
+        static int recv(lua_State* L) {
+            auto& self = to(L, 1);
+            auto& c    = checkconn(L, self, 2);
+            int rc;
+            switch (self.recv(c, rc)) {
+            case net::socket::status::close:
+                lua_pushnil(L);
+                return 1;
+            case net::socket::status::wait:
+                lua_pushboolean(L, 0);
+                return 1;
+            case net::socket::status::success:
+                lua_pushinteger(L, rc);
+                return 1;
+            case net::socket::status::failed:
+                return push_neterror(L, "recv");
+            default:
+                std::unreachable();
+            }
+        }
+        static int read(lua_State* L) {
+            auto& self = to(L, 1);
+            auto& c    = checkconn(L, self, 2);
+            size_t n   = c.in.size();
+            if (!lua_isnoneornil(L, 3)) {
+                n = (std::min)(n, lua::checkinteger<size_t>(L, 3));
+            }
+            lua_pushlstring(L, c.in.data(), n);
+            c.in.consume(n);
+            if (c.in.empty()) {
+                c.in = bytebuffer {};
+            }
+            return 1;
+        }
+        static int send(lua_State* L) {
+            auto& self = to(L, 1);
+            auto& c    = checkconn(L, self, 2);
+            auto data  = lua::checkstrview(L, 3);
+            return push_status(L, self.send(c, data.data(), data.size()), "send");
+        }
+        static int flush(lua_State* L) {
+            auto& self = to(L, 1);
+            auto& c    = checkconn(L, self, 2);
+            return push_status(L, self.flush(c), "send");
+        }
+        static int pending(lua_State* L) {
+            auto& self = to(L, 1);
+            auto& c    = checkconn(L, self, 2);
+            lua_pushinteger(L, (lua_Integer)c.out.size());
+            lua_pushinteger(L, (lua_Integer)c.in.size());
+            return 2;
+        }
+        static int get(lua_State* L) {
+            auto& self = to(L, 1);
+            lua_pushinteger(L, (lua_Integer)checkslot(L, self));
+            return 1;
+        }
+        static int set(lua_State* L) {
+            auto& self = to(L, 1);
+            auto& slot = checkslot(L, self);
+            slot       = (int64_t)luaL_checkinteger(L, 4);
+            return 0;
+        }
+        static int detach(lua_State* L) {
+            auto& self = to(L, 1);
+            auto fd    = self.detach(checkid(L, 2));
+            if (fd == net::retired_fd) {
+                return luaL_argerror(L, 2, "invalid connection id");
+            }
+            pushfd(L, fd);
+            return 1;
+        }
+        static int close(lua_State* L) {
+            auto& self = to(L, 1);
+            if (lua_isnoneornil(L, 2)) {
+                self.clear();
+                return 0;
+            }
+            lua_pushboolean(L, self.close(checkid(L, 2)));
+            return 1;
+        }
+        static int wait(lua_State* L) {
+            auto& self       = to(L, 1);
+            lua_Number timeo = timer::select_timeout(L, 2);
+            if (self.size() == 0 && timeo < 0) {
+                return luaL_error(L, "no open sockets to check and no timeout set");
+            }
+            std::vector<net::conntable::conn_id> readable;
+            std::vector<net::conntable::conn_id> writable;
+            if (!self.wait(timeo < 0 ? -1 : (int)(timeo * 1000), readable, writable)) {
+                return push_neterror(L, "poll");
+            }
+            lua_createtable(L, (int)readable.size(), 0);
+            for (size_t i = 0; i < readable.size(); ++i) {
+                lua_pushinteger(L, (lua_Integer)readable[i]);
+                lua_rawseti(L, -2, (lua_Integer)i + 1);
+            }
+            lua_createtable(L, (int)writable.size(), 0);
+            for (size_t i = 0; i < writable.size(); ++i) {
+                lua_pushinteger(L, (lua_Integer)writable[i]);
+                lua_rawseti(L, -2, (lua_Integer)i + 1);
+            }
+            return 2;
+        }
+        static int mt_len(lua_State* L) {
+            auto& self = to(L, 1);
+            lua_pushinteger(L, (lua_Integer)self.size());
+            return 1;
+        }
+        static int mt_close(lua_State* L) {
+            auto& self = to(L, 1);
+            self.clear();
+            return 0;
+        }
+        static void metatable(lua_State* L) {
+            luaL_Reg lib[] = {
+                { "add", add },
+                { "accept", accept },
+                { "recv", recv },
+                { "read", read },
+                { "send", send },
+                { "flush", flush },
+                { "pending", pending },
+                { "get", get },
+                { "set", set },
+                { "detach", detach },
+                { "close", close },
+                { "wait", wait },
+                { NULL, NULL },
+            };
+            luaL_newlibtable(L, lib);
+            luaL_setfuncs(L, lib, 0);
+            lua_setfield(L, -2, "__index");
+            luaL_Reg mt[] = {
+                { "__len", mt_len },
+                { "__close", mt_close },
+                { NULL, NULL },
+            };
+            luaL_setfuncs(L, mt, 0);
+        }
+        static int create(lua_State* L) {
+            size_t nslots = 0;
+            if (!lua_isnoneornil(L, 1)) {
+                luaL_checktype(L, 1, LUA_TTABLE);
+                if (LUA_TNIL != lua_getfield(L, 1, "slots")) {
+                    nslots = lua::checkinteger<size_t>(L, -1);
+                    luaL_argcheck(L, nslots <= kMaxSlots, 1, "too many slots");
+                }
+                lua_pop(L, 1);
+            }
+            lua::newudata<net::conntable>(L, metatable, nslots);
+            return 1;
+        }
+    }
+    namespace framer {
+        static constexpr size_t kReadSize       = 16 * 1024;
+        static constexpr size_t kDefaultMaxSize = 16 * 1024 * 1024;
+        static constexpr int kMaxSendFrames     = kMaxIobuf / 2;
+
+        static size_t header_size(header kind) {
+            switch (kind) {
+            case header::u16be:
+            case header::u16le:
+                return 2;
+            case header::u32be:
+            case header::u32le:
+                return 4;
+            default:
+                return 0;
+            }
+        }
+        static size_t read_header(header kind, const uint8_t* p) {
+            switch (kind) {
+            case header::u16be:
+                return ((size_t)p[0] << 8) | p[1];
+            case header::u16le:
+                return ((size_t)p[1] << 8) | p[0];
+            case header::u32be:
+                return ((size_t)p[0] << 24) | ((size_t)p[1] << 16) | ((size_t)p[2] << 8) | p[3];
+            case header::u32le:
+                return ((size_t)p[3] << 24) | ((size_t)p[2] << 16) | ((size_t)p[1] << 8) | p[0];
+            default:
+                std::unreachable();
+            }
+        }
+        static void write_header(header kind, uint8_t* p, size_t len) {
+            switch (kind) {
+            case header::u16be:
+                p[0] = (uint8_t)(len >> 8);
+                p[1] = (uint8_t)len;
+                break;
+            case header::u16le:
+                p[0] = (uint8_t)len;
+                p[1] = (uint8_t)(len >> 8);
+                break;
+            case header::u32be:
+                p[0] = (uint8_t)(len >> 24);
+                p[1] = (uint8_t)(len >> 16);
+                p[2] = (uint8_t)(len >> 8);
+                p[3] = (uint8_t)len;
+                break;
+            case header::u32le:
+                p[0] = (uint8_t)len;
+                p[1] = (uint8_t)(len >> 8);
+                p[2] = (uint8_t)(len >> 16);
+                p[3] = (uint8_t)(len >> 24);
+                break;
+            default:
+                std::unreachable();
+            }
+        }
+        static state& to(lua_State* L, int idx) {
+            return lua::checkudata<state>(L, idx);
+        }
+        static net::fd_t getfd(lua_State* L) {
+            lua_getiuservalue(L, 1, 1);
+            auto fd = checkfd(L, -1);
+            lua_pop(L, 1);
+            return fd;
+        }
+        static int push_error(lua_State* L, const char* msg) {
+            lua_pushnil(L);
+            lua_pushstring(L, msg);
+            return 2;
+        }
+        // drops what is left of an oversized frame; false until all of it has arrived.
+        static bool discard(state& self) {
+            if (self.skip_delim) {
+                size_t pos = self.in.find(self.delim);
+                if (pos == bytebuffer::npos) {
+                    // keep a tail that may be the start of a delimiter split across reads.
+                    size_t keep = self.delim.size() - 1;
+                    if (self.in.size() > keep) {
+                        self.in.consume(self.in.size() - keep);
+                    }
+                    return false;
+                }
+                self.in.consume(pos + self.delim.size());
+                self.skip_delim = false;
+                return true;
+            }
+            size_t n = (std::min)(self.skip, self.in.size());
+            self.in.consume(n);
+            self.skip -= n;
+            return self.skip == 0;
+        }
+        // pushes every complete frame in the input buffer into the table on top
+        // of the stack. Returns false, with nothing pushed, when the next frame
+        // is larger than max; that frame is then dropped as it arrives.
+        static bool split(lua_State* L, state& self, lua_Integer& n) {
+            for (;;) {
+                if (self.skip > 0 || self.skip_delim) {
+                    if (!discard(self)) {
+                        return true;
+                    }
+                    continue;
+                }
+                if (self.kind == header::delimiter) {
+                    size_t pos = self.in.find(self.delim);
+                    // without a delimiter, all but a possible partial one is payload.
+                    size_t len = pos != bytebuffer::npos ? pos : self.in.size() - (std::min)(self.in.size(), self.delim.size() - 1);
+                    if (len > self.max) {
+                        if (n > 0) {
+                            return true;
+                        }
+                        if (pos == bytebuffer::npos) {
+                            self.skip_delim = true;
+                        }
+                        else {
+                            self.in.consume(pos + self.delim.size());
+                        }
+                        return false;
+                    }
+                    if (pos == bytebuffer::npos) {
+                        return true;
+                    }
+                    lua_pushlstring(L, self.in.data(), pos);
+                    lua_rawseti(L, -2, ++n);
+                    self.in.consume(pos + self.delim.size());
+                    continue;
+                }
+                size_t hsize = header_size(self.kind);
+                if (self.in.size() < hsize) {
+                    return true;
+                }
+                size_t len = read_header(self.kind, (const uint8_t*)self.in.data());
+                if (len > self.max) {
+                    if (n > 0) {
+                        return true;
+                    }
+                    self.skip = hsize + len;
+                    return false;
+                }
+                if (self.in.size() < hsize + len) {
+                    return true;
+                }
+                lua_pushlstring(L, self.in.data() + hsize, len);
+                lua_rawseti(L, -2, ++n);
+                self.in.consume(hsize + len);
+            }
+        }
+        static int recv(lua_State* L) {
+            auto& self = to(L, 1);
+            auto fd    = getfd(L);
+            lua_newtable(L);
+            lua_Integer n = 0;
+            // frames left behind by an oversized one are returned before reading more.
+            if (!split(L, self, n)) {
+                return push_error(L, "frame too large");
+            }
+            if (n > 0) {
+                return 1;
+            }
+            int rc;
+            char* buf = self.in.prepare(kReadSize);
+            switch (net::socket::recv(fd, rc, buf, (int)kReadSize)) {
+            case net::socket::status::close:
+                lua_pushnil(L);
+                return 1;
+            case net::socket::status::wait:
+                lua_pushboolean(L, 0);
+                return 1;
+            case net::socket::status::success:
+                break;
+            case net::socket::status::failed:
+                return push_neterror(L, "recv");
+            default:
+                std::unreachable();
+            }
+            self.in.commit((size_t)rc);
+            if (!split(L, self, n)) {
+                return push_error(L, "frame too large");
+            }
+            return 1;
+        }
+        static bool flush_pending(state& self, net::fd_t fd, bool& failed) {
+            while (!self.out.empty()) {
+                int rc;
+                auto len = (int)(std::min)(self.out.size(), (size_t)(std::numeric_limits<int>::max)());
+                switch (net::socket::send(fd, rc, self.out.data(), len)) {
+                case net::socket::status::wait:
+                    return false;
+                case net::socket::status::success:
+                    self.out.consume((size_t)rc);
+                    break;
+                case net::socket::status::failed:
+                    failed = true;
+                    return false;
+                default:
+                    std::unreachable();
+                }
+            }
+            return true;
+        }
+        static int flush(lua_State* L) {
+            auto& self  = to(L, 1);
+            auto fd     = getfd(L);
+            bool failed = false;
+            bool done   = flush_pending(self, fd, failed);
+            if (failed) {
+                return push_neterror(L, "send");
+            }
+            lua_pushboolean(L, done);
+            return 1;
+        }
+        static int send(lua_State* L) {
+            auto& self = to(L, 1);
+            auto fd    = getfd(L);
+            int n      = lua_gettop(L) - 1;
+            luaL_argcheck(L, n > 0 && n <= kMaxSendFrames, 2, "invalid number of frames");
+            size_t hsize = header_size(self.kind);
+            dynarray<uint8_t> headers((size_t)n * 4);
+            dynarray<net::socket::iobuf> bufs((size_t)n * 2);
+            int nbufs = 0;
+            auto push = [&](const void* data, size_t len) {
+                bufs[nbufs].buf = (char*)data;
+                bufs[nbufs].len = (decltype(bufs[nbufs].len))len;
+                nbufs++;
+            };
+            for (int i = 0; i < n; ++i) {
+                auto str = lua::checkstrview(L, i + 2);
+                luaL_argcheck(L, str.size() <= self.max, i + 2, "frame too large");
+                if (self.kind == header::delimiter) {
+                    push(str.data(), str.size());
+                    push(self.delim.data(), self.delim.size());
+                    continue;
+                }
+                uint8_t* h = headers.data() + i * 4;
+                write_header(self.kind, h, str.size());
+                push(h, hsize);
+                push(str.data(), str.size());
+            }
+            bool failed = false;
+            if (!flush_pending(self, fd, failed) && failed) {
+                return push_neterror(L, "send");
+            }
+            size_t sent = 0;
+            if (self.out.empty()) {
+                int rc;
+                switch (net::socket::sendv(fd, rc, bufs.data(), nbufs)) {
+                case net::socket::status::wait:
+                    break;
+                case net::socket::status::success:
+                    sent = (size_t)rc;
+                    break;
+                case net::socket::status::failed:
+                    return push_neterror(L, "sendv");
+                default:
+                    std::unreachable();
+                }
+            }
+            // anything the kernel did not take is queued; flush() writes it out later.
+            for (int i = 0; i < nbufs; ++i) {
+                size_t len = (size_t)bufs[i].len;
+                if (sent >= len) {
+                    sent -= len;
+                    continue;
+                }
+                self.out.append(bufs[i].buf + sent, len - sent);
+                sent = 0;
+            }
+            lua_pushboolean(L, self.out.empty());
+            return 1;
+        }
+        static int pending(lua_State* L) {
+            auto& self = to(L, 1);
+            lua_pushinteger(L, (lua_Integer)self.out.size());
+            return 1;
+        }
+        static void metatable(lua_State* L) {
+            luaL_Reg lib[] = {
+                { "recv", recv },
+                { "send", send },
+                { "flush", flush },
+                { "pending", pending },
+                { NULL, NULL },
+            };
+            luaL_newlibtable(L, lib);
+            luaL_setfuncs(L, lib, 0);
+            lua_setfield(L, -2, "__index");
+        }
+        static int create(lua_State* L) {
+            checkfd(L, 1);
+            luaL_checktype(L, 2, LUA_TTABLE);
+            header kind;
+            std::string delim;
+            if (LUA_TNIL != lua_getfield(L, 2, "delimiter")) {
+                auto str = lua::checkstrview(L, -1);
+                luaL_argcheck(L, str.size() > 0, 2, "delimiter must not be empty");
+                kind  = header::delimiter;
+                delim = { str.data(), str.size() };
+            }
+            else {
+                static const char* const opts[] = {
+                    "u16be", "u16le", "u32be", "u32le",
+                    NULL
+                };
+                lua_getfield(L, 2, "header");
+                kind = (header)luaL_checkoption(L, -1, "u32be", opts);
+            }
+            lua_pop(L, 1);
+            size_t max = kDefaultMaxSize;
+            if (LUA_TNIL != lua_getfield(L, 2, "max")) {
+                max = lua::checkinteger<size_t>(L, -1);
+            }
+            lua_pop(L, 1);
+            if (kind == header::u16be || kind == header::u16le) {
+                max = (std::min)(max, (size_t)0xFFFF);
+            }
+            else if (kind != header::delimiter) {
+                max = (std::min)(max, (size_t)0xFFFFFFFF);
+            }
+            auto& self = lua::newudata<state>(L, metatable);
+            self.kind  = kind;
+            self.delim = std::move(delim);
+            self.max   = max;
+            lua_pushvalue(L, 1);
+            lua_setiuservalue(L, -2, 1);
+            return 1;
+        }
+    }
+#if defined(__linux__)
+    namespace uring {
+        enum class opkind : uint8_t {
+            free,
+            recv,
+            recv_multishot,
+            send,
+            read,
+            write,
+            accept,
+            accept_multishot,
+            connect,
+        };
+
+        struct operation {
+            opkind kind       = opkind::free;
+            int fixed         = -1;
+            lua_Integer token = 0;
+            dynarray<char> buf;
+        };
+
+        struct state {
+            net::uring::ring ring;
+            std::vector<operation> ops;
+            std::vector<size_t> freelist;
+            size_t inflight = 0;
+            dynarray<char> fixed_mem;
+            uint32_t fixed_size = 0;
+            std::vector<int> fixed_free;
+            dynarray<char> provided_mem;
+            uint32_t provided_size = 0;
+            std::vector<uint16_t> unprovided;
+            ~state() {
+                shutdown();
+            }
+            void shutdown() noexcept;
+        };
+    }
+}
+
+namespace bee::lua {
+    template <>
+    struct udata<lua_socket::uring::state> {
+        static inline auto name = "bee::net::uring";
+    };
+}
+
+namespace bee::lua_socket {
+    namespace uring {
+        static constexpr uint16_t kProvidedGroup    = 0;
+        static constexpr uint64_t kInternalUserData = 0;
+
+        static state& to(lua_State* L, int idx) {
+            auto& self = lua::checkudata<state>(L, idx);
+            if (!self.ring.valid()) {
+                luaL_error(L, "uring is already closed.");
+            }
+            return self;
+        }
+
+        static net::fd_t checkhandle(lua_State* L, int idx) {
+            if (auto p = (luaL_Stream*)luaL_testudata(L, idx, "bee::file")) {
+                luaL_argcheck(L, p->closef != NULL, idx, "attempt to use a closed file");
+                return fileno(p->f);
+            }
+            if (auto p = (luaL_Stream*)luaL_testudata(L, idx, LUA_FILEHANDLE)) {
+                luaL_argcheck(L, p->closef != NULL, idx, "attempt to use a closed file");
+                return fileno(p->f);
+            }
+            return checkfd(L, idx);
+        }
+
+        static bool make_room(state& self) {
+            if (self.ring.space() != 0) {
+                return true;
+            }
+            if (self.ring.submit() < 0) {
+                return false;
+            }
+            if (self.ring.space() == 0) {
+                errno = EBUSY;
+                return false;
+            }
+            return true;
+        }
+
+        static std::optional<size_t> alloc(lua_State* L, state& self, opkind kind) {
+            // every argument is checked before a slot is taken, so an error cannot leak it.
+            lua_Integer token = luaL_checkinteger(L, 3);
+            if (!make_room(self)) {
+                return std::nullopt;
+            }
+            size_t index;
+            if (self.freelist.empty()) {
+                index = self.ops.size();
+                self.ops.emplace_back();
+            }
+            else {
+                index = self.freelist.back();
+                self.freelist.pop_back();
+            }
+            auto& op = self.ops[index];
+            op.kind  = kind;
+            op.fixed = -1;
+            op.token = token;
+            self.inflight++;
+            return index;
+        }
+
+        static void release(state& self, size_t index) {
+            auto& op = self.ops[index];
+            if (op.fixed >= 0) {
+                self.fixed_free.push_back(op.fixed);
+            }
+            op.kind  = opkind::free;
+            op.fixed = -1;
+            op.buf   = dynarray<char>();
+            self.freelist.push_back(index);
+            self.inflight--;
+        }
+
+        static uint64_t user_data(size_t index) {
+            return (uint64_t)index + 1;
+        }
+
+        static char* fixed_buffer(state& self, int index) {
+            return self.fixed_mem.data() + (size_t)index * self.fixed_size;
+        }
+
+        static int take_fixed(state& self, size_t len) {
+            if (self.fixed_free.empty() || len > self.fixed_size) {
+                return -1;
+            }
+            int index = self.fixed_free.back();
+            self.fixed_free.pop_back();
+            return index;
+        }
+
+        static int submit_failed(lua_State* L, state& self, size_t index, const char* what) {
+            release(self, index);
+            return push_neterror(L, what);
+        }
+
+        static int push_queued(lua_State* L) {
+            lua_pushboolean(L, 1);
+            return 1;
+        }
+
+        static int recv(lua_State* L) {
+            auto& self = to(L, 1);
+            auto fd    = checkfd(L, 2);
+            auto len   = lua::optinteger<uint32_t, LUAL_BUFFERSIZE>(L, 4);
+            auto slot  = alloc(L, self, opkind::recv);
+            if (!slot) {
+                return push_neterror(L, "io_uring_enter");
+            }
+            size_t index = *slot;
+            auto& op     = self.ops[index];
+            op.buf       = dynarray<char>(len);
+            if (!self.ring.recv(fd, op.buf.data(), len, user_data(index))) {
+                return submit_failed(L, self, index, "io_uring");
+            }
+            return push_queued(L);
+        }
+
+        static int recv_multishot(lua_State* L) {
+            auto& self = to(L, 1);
+            auto fd    = checkfd(L, 2);
+            if (self.provided_size == 0) {
+                return luaL_error(L, "recv_multishot requires provide_buffers.");
+            }
+            auto slot   = alloc(L, self, opkind::recv_multishot);
+            if (!slot) {
+                return push_neterror(L, "io_uring_enter");
+            }
+            size_t index = *slot;
+            if (!self.ring.recv_multishot(fd, kProvidedGroup, user_data(index))) {
+                return submit_failed(L, self, index, "io_uring");
+            }
+            return push_queued(L);
+        }
+
+        static int send(lua_State* L) {
+            auto& self = to(L, 1);
+            auto fd    = checkfd(L, 2);
+            auto data  = lua::checkstrview(L, 4);
+            auto slot  = alloc(L, self, opkind::send);
+            if (!slot) {
+                return push_neterror(L, "io_uring_enter");
+            }
+            size_t index = *slot;
+            auto& op     = self.ops[index];
+            op.buf       = dynarray<char>(data.data(), data.size());
+            if (!self.ring.send(fd, op.buf.data(), (uint32_t)data.size(), user_data(index))) {
+                return submit_failed(L, self, index, "io_uring");
+            }
+            return push_queued(L);
+        }
+
+        static int read(lua_State* L) {
+            auto& self  = to(L, 1);
+            auto fd     = checkhandle(L, 2);
+            auto len    = lua::checkinteger<uint32_t>(L, 4);
+            auto offset = lua::optinteger<int64_t, -1>(L, 5);
+            auto slot   = alloc(L, self, opkind::read);
+            if (!slot) {
+                return push_neterror(L, "io_uring_enter");
+            }
+            size_t index = *slot;
+            auto& op     = self.ops[index];
+            op.fixed     = take_fixed(self, len);
+            char* buf;
+            if (op.fixed >= 0) {
+                buf = fixed_buffer(self, op.fixed);
+            }
+            else {
+                op.buf = dynarray<char>(len);
+                buf    = op.buf.data();
+            }
+            if (!self.ring.read(fd, buf, len, (uint64_t)offset, user_data(index), op.fixed)) {
+                return submit_failed(L, self, index, "io_uring");
+            }
+            return push_queued(L);
+        }
+
+        static int write(lua_State* L) {
+            auto& self  = to(L, 1);
+            auto fd     = checkhandle(L, 2);
+            auto data   = lua::checkstrview(L, 4);
+            auto offset = lua::optinteger<int64_t, -1>(L, 5);
+            auto slot   = alloc(L, self, opkind::write);
+            if (!slot) {
+                return push_neterror(L, "io_uring_enter");
+            }
+            size_t index = *slot;
+            auto& op     = self.ops[index];
+            op.fixed     = take_fixed(self, data.size());
+            char* buf;
+            if (op.fixed >= 0) {
+                buf = fixed_buffer(self, op.fixed);
+                memcpy(buf, data.data(), data.size());
+            }
+            else {
+                op.buf = dynarray<char>(data.data(), data.size());
+                buf    = op.buf.data();
+            }
+            if (!self.ring.write(fd, buf, (uint32_t)data.size(), (uint64_t)offset, user_data(index), op.fixed)) {
+                return submit_failed(L, self, index, "io_uring");
+            }
+            return push_queued(L);
+        }
+
+        static int accept(lua_State* L) {
+            auto& self     = to(L, 1);
+            auto fd        = checkfd(L, 2);
+            bool multishot = lua_toboolean(L, 4);
+            auto slot      = alloc(L, self, multishot ? opkind::accept_multishot : opkind::accept);
+            if (!slot) {
+                return push_neterror(L, "io_uring_enter");
+            }
+            size_t index = *slot;
+            if (!self.ring.accept(fd, multishot, user_data(index))) {
+                return submit_failed(L, self, index, "io_uring");
+            }
+            return push_queued(L);
+        }
+
+        static int connect(lua_State* L) {
+            auto& self = to(L, 1);
+            auto fd    = checkfd(L, 2);
+            auto ep    = read_endpoint(L, 4);
+            auto slot  = alloc(L, self, opkind::connect);
+            if (!slot) {
+                return push_neterror(L, "io_uring_enter");
+            }
+            size_t index = *slot;
+            auto& op     = self.ops[index];
+            op.buf       = dynarray<char>((const char*)ep.addr(), ep.addrlen());
+            if (!self.ring.connect(fd, op.buf.data(), (uint32_t)op.buf.size(), user_data(index))) {
+                return submit_failed(L, self, index, "io_uring");
+            }
+            return push_queued(L);
+        }
+
+        static int cancel(lua_State* L) {
+            auto& self        = to(L, 1);
+            lua_Integer token = luaL_checkinteger(L, 2);
+            lua_Integer n     = 0;
+            for (size_t i = 0; i < self.ops.size(); ++i) {
+                if (self.ops[i].kind != opkind::free && self.ops[i].token == token) {
+                    if (!make_room(self) || !self.ring.cancel(user_data(i), kInternalUserData)) {
+                        return push_neterror(L, "io_uring_enter");
+                    }
+                    n++;
+                }
+            }
+            lua_pushinteger(L, n);
+            return 1;
+        }
+
+        static int register_buffers(lua_State* L) {
+            auto& self = to(L, 1);
+            auto n     = lua::checkinteger<uint16_t>(L, 2);
+            auto size  = lua::checkinteger<uint32_t>(L, 3);
+            luaL_argcheck(L, n > 0, 2, "must be positive");
+            luaL_argcheck(L, size > 0, 3, "must be positive");
+            if (self.fixed_size != 0) {
+                return luaL_error(L, "buffers are already registered.");
+            }
+            dynarray<char> mem((size_t)n * size);
+            dynarray<net::uring::buffer> bufs(n);
+            for (uint16_t i = 0; i < n; ++i) {
+                bufs[i] = { mem.data() + (size_t)i * size, size };
+            }
+            if (!self.ring.register_buffers(bufs.data(), n)) {
+                return push_neterror(L, "io_uring_register");
+            }
+            self.fixed_mem  = std::move(mem);
+            self.fixed_size = size;
+            for (int i = n - 1; i >= 0; --i) {
+                self.fixed_free.push_back(i);
+            }
+            lua_pushboolean(L, 1);
+            return 1;
+        }
+
+        static int provide_buffers(lua_State* L) {
+            auto& self = to(L, 1);
+            auto n     = lua::checkinteger<uint16_t>(L, 2);
+            auto size  = lua::checkinteger<uint32_t>(L, 3);
+            luaL_argcheck(L, n > 0, 2, "must be positive");
+            luaL_argcheck(L, size > 0, 3, "must be positive");
+            if (self.provided_size != 0) {
+                return luaL_error(L, "buffers are already provided.");
+            }
+            dynarray<char> mem((size_t)n * size);
+            if (!make_room(self)) {
+                return push_neterror(L, "io_uring_enter");
+            }
+            if (!self.ring.provide_buffers(mem.data(), size, n, kProvidedGroup, 0, kInternalUserData)) {
+                return push_neterror(L, "io_uring");
+            }
+            self.provided_mem  = std::move(mem);
+            self.provided_size = size;
+            lua_pushboolean(L, 1);
+            return 1;
+        }
+
+        // hands consumed buffers back to the kernel; ones that did not fit
+        // stay queued and are retried by the next submit or wait.
+        static bool reprovide(state& self) {
+            while (!self.unprovided.empty()) {
+                uint16_t bid = self.unprovided.back();
+                if (!make_room(self)) {
+                    return false;
+                }
+                if (!self.ring.provide_buffers(self.provided_mem.data() + (size_t)bid * self.provided_size, self.provided_size, 1, kProvidedGroup, bid, kInternalUserData)) {
+                    return false;
+                }
+                self.unprovided.pop_back();
+            }
+            return true;
+        }
+
+        static void push_completion(lua_State* L, state& self, const net::uring::completion& c) {
+            size_t index = (size_t)(c.user_data - 1);
+            auto& op     = self.ops[index];
+            bool more    = c.more();
+            lua_createtable(L, 0, 3);
+            lua_pushinteger(L, op.token);
+            lua_setfield(L, -2, "token");
+            if (c.res < 0) {
+                auto error = make_error(std::error_code(-c.res, std::generic_category()), "io_uring");
+                lua_pushstring(L, error.c_str());
+                lua_setfield(L, -2, "error");
+            }
+            else {
+                switch (op.kind) {
+                case opkind::recv:
+                case opkind::read:
+                    if (c.res == 0) {
+                        break;
+                    }
+                    lua_pushlstring(L, op.fixed >= 0 ? fixed_buffer(self, op.fixed) : op.buf.data(), (size_t)c.res);
+                    lua_setfield(L, -2, "result");
+                    break;
+                case opkind::recv_multishot:
+                    if (c.has_buffer()) {
+                        uint16_t bid = c.buffer_id();
+                        if (c.res > 0) {
+                            lua_pushlstring(L, self.provided_mem.data() + (size_t)bid * self.provided_size, (size_t)c.res);
+                            lua_setfield(L, -2, "result");
+                        }
+                        self.unprovided.push_back(bid);
+                    }
+                    break;
+                case opkind::send:
+                case opkind::write:
+                    lua_pushinteger(L, c.res);
+                    lua_setfield(L, -2, "result");
+                    break;
+                case opkind::accept:
+                case opkind::accept_multishot:
+                    pushfd(L, (net::fd_t)c.res);
+                    lua_setfield(L, -2, "result");
+                    break;
+                case opkind::connect:
+                    lua_pushboolean(L, 1);
+                    lua_setfield(L, -2, "result");
+                    break;
+                default:
+                    std::unreachable();
+                }
+            }
+            if (more) {
+                lua_pushboolean(L, 1);
+                lua_setfield(L, -2, "more");
+            }
+            else {
+                release(self, index);
+            }
+        }
+
+        static int submit(lua_State* L) {
+            auto& self = to(L, 1);
+            if (!reprovide(self)) {
+                return push_neterror(L, "io_uring_enter");
+            }
+            int rc = self.ring.submit();
+            if (rc < 0) {
+                return push_neterror(L, "io_uring_enter");
+            }
+            lua_pushinteger(L, rc);
+            return 1;
+        }
+
+        static int wait(lua_State* L) {
+            auto& self = to(L, 1);
+            auto min   = lua::optinteger<unsigned, 1>(L, 2);
+            if (self.inflight == 0) {
+                min = 0;
+            }
+            if (!reprovide(self)) {
+                return push_neterror(L, "io_uring_enter");
+            }
+            if (self.ring.submit(min) < 0 && errno != EBUSY) {
+                return push_neterror(L, "io_uring_enter");
+            }
+            lua_newtable(L);
+            lua_Integer n = 0;
+            net::uring::completion cqes[64];
+            for (;;) {
+                size_t count = self.ring.harvest(cqes, sizeof(cqes) / sizeof(cqes[0]));
+                for (size_t i = 0; i < count; ++i) {
+                    if (cqes[i].user_data == kInternalUserData) {
+                        continue;
+                    }
+                    push_completion(L, self, cqes[i]);
+                    lua_rawseti(L, -2, ++n);
+                }
+                if (count < sizeof(cqes) / sizeof(cqes[0])) {
+                    break;
+                }
+            }
+            // a failure here is reported by the next call, which retries it.
+            reprovide(self);
+            return 1;
+        }
+
+        void state::shutdown() noexcept {
+            if (!ring.valid()) {
+                return;
+            }
+            // the kernel tears the ring down asynchronously and may still write
+            // into the buffers of in-flight ops, so cancel and reap them first.
+            // Cancels go out as far as the ring has room and the rest follow
+            // after reaping; waiting with an op left uncancelled could block
+            // forever on an idle recv.
+            net::uring::completion cqes[64];
+            size_t next = 0;
+            while (inflight > 0) {
+                if (ring.space() == 0 && ring.submit() < 0) {
+                    break;
+                }
+                bool refused  = false;
+                size_t queued = 0;
+                for (; next < ops.size() && ring.space() != 0; ++next) {
+                    if (ops[next].kind == opkind::free) {
+                        continue;
+                    }
+                    if (!ring.cancel(user_data(next), kInternalUserData)) {
+                        refused = true;
+                        break;
+                    }
+                    queued++;
+                }
+                if (refused || (queued == 0 && next < ops.size())) {
+                    // no way to reach the remaining ops; fall through to the leak below.
+                    break;
+                }
+                // every submit here carries at least one cancel or all of them are out,
+                // so a completion is on its way.
+                if (ring.submit(1) < 0) {
+                    break;
+                }
+                size_t count = ring.harvest(cqes, sizeof(cqes) / sizeof(cqes[0]));
+                for (size_t i = 0; i < count; ++i) {
+                    if (cqes[i].user_data != kInternalUserData && !cqes[i].more()) {
+                        release(*this, (size_t)(cqes[i].user_data - 1));
+                    }
+                }
+            }
+            ring.close();
+            if (inflight > 0) {
+                // could not be drained; leaking is the only safe choice left.
+                for (auto& op : ops) {
+                    if (op.kind != opkind::free) {
+                        (void)op.buf.release();
+                    }
+                }
+                (void)fixed_mem.release();
+                (void)provided_mem.release();
+            }
+        }
+
+        static int close(lua_State* L) {
+            auto& self = lua::checkudata<state>(L, 1);
+            self.shutdown();
+            return 0;
+        }
+
+        static void metatable(lua_State* L) {
+            luaL_Reg lib[] = {
+                { "recv", recv },
+                { "recv_multishot", recv_multishot },
+                { "send", send },
+                { "read", read },
+                { "write", write },
+                { "accept", accept },
+                { "connect", connect },
+                { "cancel", cancel },
+                { "register_buffers", register_buffers },
+                { "provide_buffers", provide_buffers },
+                { "submit", submit },
+                { "wait", wait },
+                { "close", close },
+                { NULL, NULL },
+            };
+            luaL_newlibtable(L, lib);
+            luaL_setfuncs(L, lib, 0);
+            lua_setfield(L, -2, "__index");
+            luaL_Reg mt[] = {
+                { "__close", close },
+                { NULL, NULL },
+            };
+            luaL_setfuncs(L, mt, 0);
+        }
+
+        static int create(lua_State* L) {
+            auto entries = lua::optinteger<unsigned, 256>(L, 1);
+            auto& self   = lua::newudata<state>(L, metatable);
+            if (!self.ring.init(entries)) {
+                return push_neterror(L, "io_uring_setup");
+            }
+            return 1;
+        }
+    }
+#else
+    namespace uring {
+        static int create(lua_State* L) {
+            lua_pushnil(L);
+            lua_pushstring(L, make_error(std::make_error_code(std::errc::function_not_supported), "io_uring_setup").c_str());
+            return 2;
+        }
+    }
+#endif
 #if defined(_WIN32)
     struct socket_set {
         struct storage {
@@ -419,7 +2633,7 @@ namespace bee::lua_socket {
             write_finish = false;
         else if (!lua_isnoneornil(L, 2))
             luaL_typeerror(L, 2, lua_typename(L, LUA_TTABLE));
-        lua_Number timeo = luaL_optnumber(L, 3, -1);
+        lua_Number timeo = timer::select_timeout(L, 3);
         if (read_finish && write_finish) {
             if (timeo < 0) {
                 return luaL_error(L, "no open sockets to check and no timeout set");
@@ -500,7 +2714,7 @@ namespace bee::lua_socket {
             write_finish = false;
         else if (!lua_isnoneornil(L, 2))
             luaL_typeerror(L, 2, lua_typename(L, LUA_TTABLE));
-        lua_Number timeo = luaL_optnumber(L, 3, -1);
+        lua_Number timeo = timer::select_timeout(L, 3);
         if (read_finish && write_finish) {
             if (timeo < 0) {
                 return luaL_error(L, "no open sockets to check and no timeout set");
@@ -601,8 +2815,20 @@ namespace bee::lua_socket {
         }
         luaL_Reg lib[] = {
             { "pair", pair },
+            { "pipe", pipe },
             { "select", select },
             { "fd", fd },
+            { "listen_group", listen_group },
+            { "stats", stats },
+            { "endpoint", endpoint },
+            { "endpoint_info", endpoint_info },
+            { "buffer", buffer::create },
+            { "resolver", resolver::create },
+            { "framer", framer::create },
+            { "timer", timer::create },
+            { "pool", pool::create },
+            { "conntable", conntable::create },
+            { "uring", uring::create },
             { NULL, NULL }
         };
         luaL_newlibtable(L, lib);
@@ -9,6 +9,7 @@
 #include <errno.h>
 #include <signal.h>
 
+#include <algorithm>
 #include <optional>
 #if defined(_WIN32)
 #    include <Windows.h>
@@ -16,15 +17,26 @@
 #    include <fcntl.h>
 #    include <io.h>
 #else
+#    include <fcntl.h>
+#    include <sys/resource.h>
 #    include <unistd.h>
 #endif
 
 namespace bee::lua {
     template <>
     struct udata<subprocess::process> {
-        static inline int nupvalue = 1;
+        static inline int nupvalue = 2;
         static inline auto name    = "bee::subprocess";
     };
+    template <>
+    struct udata<subprocess::spawn_cache> {
+        static inline auto name = "bee::subprocess::batch";
+    };
+    template <>
+    struct udata<file_handle> {
+        static inline int nupvalue = 1;
+        static inline auto name    = "bee::subprocess::pipe";
+    };
 }
 
 namespace bee::lua_subprocess {
@@ -54,11 +66,29 @@ namespace bee::lua_subprocess {
             return 0;
         }
 
+        static void push_usage(lua_State* L, const subprocess::resource_usage& usage) {
+            lua_createtable(L, 0, 5);
+            lua_pushnumber(L, (lua_Number)usage.utime_us / 1000000);
+            lua_setfield(L, -2, "utime");
+            lua_pushnumber(L, (lua_Number)usage.stime_us / 1000000);
+            lua_setfield(L, -2, "stime");
+            lua_pushinteger(L, (lua_Integer)usage.maxrss);
+            lua_setfield(L, -2, "maxrss");
+            lua_pushinteger(L, (lua_Integer)usage.inblock);
+            lua_setfield(L, -2, "inblock");
+            lua_pushinteger(L, (lua_Integer)usage.oublock);
+            lua_setfield(L, -2, "oublock");
+        }
+
         static int wait(lua_State* L) {
             auto& self  = to(L, 1);
             auto status = self.wait();
             if (status) {
                 lua_pushinteger(L, (lua_Integer)*status);
+                if (auto usage = self.usage()) {
+                    push_usage(L, *usage);
+                    return 2;
+                }
                 return 1;
             }
             auto error = make_syserror("subprocess::wait");
@@ -67,6 +97,16 @@ namespace bee::lua_subprocess {
             return 2;
         }
 
+        static int usage(lua_State* L) {
+            auto& self = to(L, 1);
+            auto usage = self.usage();
+            if (!usage) {
+                return 0;
+            }
+            push_usage(L, *usage);
+            return 1;
+        }
+
         static int kill(lua_State* L) {
             auto& self  = to(L, 1);
             auto signum = lua::optinteger<int, SIGTERM>(L, 2);
@@ -103,6 +143,36 @@ namespace bee::lua_subprocess {
             return 1;
         }
 
+        static int fd(lua_State* L) {
+#if defined(_WIN32)
+            return 0;
+#else
+            auto& self = to(L, 1);
+            if (LUA_TUSERDATA == lua_getiuservalue(L, 1, 2)) {
+                return 1;
+            }
+            lua_pop(L, 1);
+            int fd = self.fd();
+            if (fd == -1) {
+                return 0;
+            }
+            // a socket object owning a dup, so closing it leaves the process intact.
+            int dupfd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+            if (dupfd == -1) {
+                lua_pushnil(L);
+                lua_pushstring(L, make_syserror("dup").c_str());
+                return 2;
+            }
+            if (!lua::pushsocket(L, dupfd)) {
+                ::close(dupfd);
+                return 0;
+            }
+            lua_pushvalue(L, -1);
+            lua_setiuservalue(L, 1, 2);
+            return 1;
+#endif
+        }
+
         static int mt_index(lua_State* L) {
             lua_pushvalue(L, 2);
             if (LUA_TNIL != lua_rawget(L, lua_upvalueindex(1))) {
@@ -134,11 +204,13 @@ namespace bee::lua_subprocess {
         static void metatable(lua_State* L) {
             static luaL_Reg lib[] = {
                 { "wait", wait },
+                { "usage", usage },
                 { "kill", kill },
                 { "get_id", get_id },
                 { "is_running", is_running },
                 { "resume", resume },
                 { "native_handle", native_handle },
+                { "fd", fd },
                 { NULL, NULL }
             };
             luaL_newlibtable(L, lib);
@@ -160,6 +232,179 @@ namespace bee::lua_subprocess {
         }
     }
 
+    namespace pipe {
+        static auto& to(lua_State* L, int idx) {
+            return lua::checkudata<file_handle>(L, idx);
+        }
+
+        static int push_error(lua_State* L, const char* what) {
+            auto error = make_syserror(what);
+            lua_pushnil(L);
+            lua_pushstring(L, error.c_str());
+            return 2;
+        }
+
+        static bool would_block() {
+#if defined(_WIN32)
+            return false;
+#else
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+        }
+
+        // reads what is available straight into the result buffer: a string,
+        // false when nothing is ready yet, nil at end of stream.
+        static int read(lua_State* L) {
+            auto& self        = to(L, 1);
+            lua_Integer limit = luaL_optinteger(L, 2, LUA_MAXINTEGER);
+            luaL_argcheck(L, limit > 0, 2, "out of range");
+            if (!self) {
+                errno = EBADF;
+                return push_error(L, "subprocess::pipe::read");
+            }
+            luaL_Buffer b;
+            luaL_buffinit(L, &b);
+            lua_Integer total = 0;
+            bool eof          = false;
+            while (total < limit) {
+                size_t want = (size_t)(std::min)((lua_Integer)LUAL_BUFFERSIZE, limit - total);
+                char* buf   = luaL_prepbuffsize(&b, want);
+                int rc      = subprocess::pipe::read(self, buf, want);
+                if (rc > 0) {
+                    luaL_addsize(&b, (size_t)rc);
+                    total += rc;
+                    continue;
+                }
+                if (rc == 0) {
+                    eof = true;
+                    break;
+                }
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (would_block()) {
+                    break;
+                }
+                if (total > 0) {
+                    break;
+                }
+                luaL_pushresult(&b);
+                lua_pop(L, 1);
+                return push_error(L, "subprocess::pipe::read");
+            }
+            luaL_pushresult(&b);
+            if (total > 0) {
+                return 1;
+            }
+            lua_pop(L, 1);
+            if (eof) {
+                lua_pushnil(L);
+                return 1;
+            }
+            lua_pushboolean(L, 0);
+            return 1;
+        }
+
+        // returns the number of bytes written, or false when the pipe is full.
+        static int write(lua_State* L) {
+            auto& self = to(L, 1);
+            auto data  = lua::checkstrview(L, 2);
+            if (!self) {
+                errno = EBADF;
+                return push_error(L, "subprocess::pipe::write");
+            }
+            for (;;) {
+                int rc = subprocess::pipe::write(self, data.data(), data.size());
+                if (rc >= 0) {
+                    lua_pushinteger(L, rc);
+                    return 1;
+                }
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (would_block()) {
+                    lua_pushboolean(L, 0);
+                    return 1;
+                }
+                return push_error(L, "subprocess::pipe::write");
+            }
+        }
+
+        static int fd(lua_State* L) {
+#if defined(_WIN32)
+            return 0;
+#else
+            auto& self = to(L, 1);
+            if (!self) {
+                return 0;
+            }
+            if (LUA_TUSERDATA == lua_getiuservalue(L, 1, 1)) {
+                return 1;
+            }
+            lua_pop(L, 1);
+            // a socket object owning a dup; close() below closes it too, so
+            // the other end still sees the pipe go away.
+            int dupfd = ::fcntl(self.value(), F_DUPFD_CLOEXEC, 0);
+            if (dupfd == -1) {
+                return push_error(L, "dup");
+            }
+            if (!lua::pushsocket(L, dupfd)) {
+                ::close(dupfd);
+                return 0;
+            }
+            lua_pushvalue(L, -1);
+            lua_setiuservalue(L, 1, 1);
+            return 1;
+#endif
+        }
+
+        static int close(lua_State* L) {
+            auto& self = to(L, 1);
+            if (self) {
+                self.close();
+                self = {};
+            }
+            if (LUA_TUSERDATA == lua_getiuservalue(L, 1, 1)) {
+                if (luaL_callmeta(L, -1, "__close")) {
+                    lua_pop(L, 1);
+                }
+                lua_pushnil(L);
+                lua_setiuservalue(L, 1, 1);
+            }
+            lua_pop(L, 1);
+            lua_pushboolean(L, 1);
+            return 1;
+        }
+
+        static int mt_close(lua_State* L) {
+            close(L);
+            return 0;
+        }
+
+        static void metatable(lua_State* L) {
+            static luaL_Reg lib[] = {
+                { "read", read },
+                { "write", write },
+                { "fd", fd },
+                { "close", close },
+                { NULL, NULL }
+            };
+            luaL_newlibtable(L, lib);
+            luaL_setfuncs(L, lib, 0);
+            lua_setfield(L, -2, "__index");
+            static luaL_Reg mt[] = {
+                { "__close", mt_close },
+                { "__gc", mt_close },
+                { NULL, NULL }
+            };
+            luaL_setfuncs(L, mt, 0);
+        }
+
+        static void constructor(lua_State* L, file_handle h) {
+            lua::newudata<file_handle>(L, metatable, h);
+        }
+    }
+
     namespace spawn {
         static std::optional<lua::string_type> cast_cwd(lua_State* L) {
             lua_getfield(L, 1, "cwd");
@@ -279,6 +524,27 @@ namespace bee::lua_subprocess {
                     lua_pushvalue(L, -1);
                     return handle;
                 }
+                if (strcmp(lua_tostring(L, -1), "async") == 0) {
+                    // the parent keeps a raw non-blocking end instead of a FILE*.
+                    auto pipe = subprocess::pipe::open();
+                    if (!pipe) {
+                        break;
+                    }
+                    bool input          = strcmp(name, "stdin") == 0;
+                    file_handle& parent = input ? pipe.wr : pipe.rd;
+                    file_handle& child  = input ? pipe.rd : pipe.wr;
+                    if (!subprocess::pipe::set_nonblock(parent)) {
+                        auto error = make_syserror("subprocess::pipe::set_nonblock");
+                        parent.close();
+                        child.close();
+                        lua_pushstring(L, error.c_str());
+                        lua_error(L);
+                    }
+                    lua_pop(L, 1);
+                    pipe::constructor(L, parent);
+                    return child;
+                }
+                break;
             }
             default:
                 break;
@@ -295,7 +561,7 @@ namespace bee::lua_subprocess {
             return f;
         }
 
-        static void cast_env(lua_State* L, subprocess::spawn& self) {
+        static subprocess::envbuilder cast_envbuilder(lua_State* L) {
             subprocess::envbuilder builder;
             if (LUA_TTABLE == lua_getfield(L, 1, "env")) {
                 lua_pushnil(L);
@@ -310,7 +576,11 @@ namespace bee::lua_subprocess {
                 }
             }
             lua_pop(L, 1);
-            self.env(builder.release());
+            return builder;
+        }
+
+        static void cast_env(lua_State* L, subprocess::spawn& self) {
+            self.env(cast_envbuilder(L).release());
         }
 
         static void cast_suspended(lua_State* L, subprocess::spawn& self) {
@@ -367,11 +637,54 @@ namespace bee::lua_subprocess {
             }
             lua_pop(L, 1);
         }
+        static void cast_limits(lua_State* L, subprocess::spawn&) {
+            if (LUA_TNIL != lua_getfield(L, 1, "limits")) {
+                luaL_error(L, "limits is not supported on this platform.");
+                return;
+            }
+            lua_pop(L, 1);
+        }
+
+        static bool cast_cgroup(lua_State* L, subprocess::spawn&) {
+            if (LUA_TNIL != lua_getfield(L, 1, "cgroup")) {
+                luaL_error(L, "cgroup is not supported on this platform.");
+                return false;
+            }
+            lua_pop(L, 1);
+            return true;
+        }
 #else
         static void cast_option(lua_State*, subprocess::spawn&) {}
+
+        static void cast_limit(lua_State* L, subprocess::spawn& self, const char* name, int resource) {
+            if (LUA_TNIL != lua_getfield(L, -1, name)) {
+                auto value = luaL_checkinteger(L, -1);
+                luaL_argcheck(L, value >= 0, 1, "limits must not be negative");
+                self.limit(resource, (uint64_t)value);
+            }
+            lua_pop(L, 1);
+        }
+
+        static void cast_limits(lua_State* L, subprocess::spawn& self) {
+            if (LUA_TTABLE == lua_getfield(L, 1, "limits")) {
+                cast_limit(L, self, "memory", RLIMIT_AS);
+                cast_limit(L, self, "cpu", RLIMIT_CPU);
+                cast_limit(L, self, "nofile", RLIMIT_NOFILE);
+            }
+            lua_pop(L, 1);
+        }
+
+        static bool cast_cgroup(lua_State* L, subprocess::spawn& self) {
+            bool ok = true;
+            if (LUA_TSTRING == lua_getfield(L, 1, "cgroup")) {
+                ok = self.cgroup(lua_tostring(L, -1));
+            }
+            lua_pop(L, 1);
+            return ok;
+        }
 #endif
 
-        static int spawn(lua_State* L) {
+        static int spawn_with(lua_State* L, subprocess::spawn_cache* cache) {
             luaL_checktype(L, 1, LUA_TTABLE);
             subprocess::spawn spawn;
             subprocess::args_t args = cast_args(L);
@@ -380,10 +693,25 @@ namespace bee::lua_subprocess {
             }
 
             auto cwd = cast_cwd(L);
-            cast_env(L, spawn);
+            if (cache) {
+                if (LUA_TNIL != lua_getfield(L, 1, "env")) {
+                    return luaL_error(L, "the environment of a batch is fixed when it is created.");
+                }
+                lua_pop(L, 1);
+                spawn.cache(*cache);
+            }
+            else {
+                cast_env(L, spawn);
+            }
             cast_suspended(L, spawn);
             cast_option(L, spawn);
             cast_detached(L, spawn);
+            cast_limits(L, spawn);
+            if (!cast_cgroup(L, spawn)) {
+                lua_pushnil(L);
+                lua_pushstring(L, make_syserror("subprocess::cgroup").c_str());
+                return 2;
+            }
 
             file_handle f_stdin  = cast_stdio(L, spawn, "stdin", subprocess::stdio::eInput);
             file_handle f_stdout = cast_stdio(L, spawn, "stdout", subprocess::stdio::eOutput);
@@ -408,6 +736,41 @@ namespace bee::lua_subprocess {
             }
             return 1;
         }
+
+        static int spawn(lua_State* L) {
+            return spawn_with(L, nullptr);
+        }
+    }
+
+    namespace batch {
+        static int spawn(lua_State* L) {
+            auto& self = lua::checkudata<subprocess::spawn_cache>(L, 1);
+            luaL_checktype(L, 2, LUA_TTABLE);
+            lua_settop(L, 2);
+            // the options go first as for subprocess.spawn; the batch stays on the stack.
+            lua_rotate(L, 1, 1);
+            return spawn::spawn_with(L, &self);
+        }
+
+        static void metatable(lua_State* L) {
+            static luaL_Reg lib[] = {
+                { "spawn", spawn },
+                { NULL, NULL }
+            };
+            luaL_newlibtable(L, lib);
+            luaL_setfuncs(L, lib, 0);
+            lua_setfield(L, -2, "__index");
+        }
+
+        static int create(lua_State* L) {
+            subprocess::envbuilder builder;
+            if (!lua_isnoneornil(L, 1)) {
+                luaL_checktype(L, 1, LUA_TTABLE);
+                builder = spawn::cast_envbuilder(L);
+            }
+            lua::newudata<subprocess::spawn_cache>(L, metatable, builder.release());
+            return 1;
+        }
     }
 
     static int select(lua_State* L) {
@@ -421,12 +784,15 @@ namespace bee::lua_subprocess {
             set[i]  = &p;
             lua_pop(L, 1);
         }
-        switch (subprocess::process_select(set, timeout)) {
+        std::vector<size_t> exited;
+        switch (subprocess::process_select(set, timeout, exited)) {
         case subprocess::status::success:
-            lua_pushboolean(L, 1);
-            return 1;
         case subprocess::status::timeout:
-            lua_pushboolean(L, 1);
+            lua_createtable(L, (int)exited.size(), 0);
+            for (size_t i = 0; i < exited.size(); ++i) {
+                lua_geti(L, 1, (lua_Integer)exited[i] + 1);
+                lua_rawseti(L, -2, (lua_Integer)i + 1);
+            }
             return 1;
         case subprocess::status::failed: {
             auto error = make_syserror("process_select");
@@ -564,6 +930,7 @@ return table.concat(t)
     static int luaopen(lua_State* L) {
         static luaL_Reg lib[] = {
             { "spawn", spawn::spawn },
+            { "batch", batch::create },
             { "select", select },
             { "peek", peek },
             { "filemode", filemode },
@@ -1,3 +1,4 @@
+#include <bee/time/monotonic.h>
 #include <binding/binding.h>
 
 #if defined(_WIN32)
@@ -7,16 +8,6 @@
 #endif
 
 namespace bee::lua_time {
-    static uint64_t time_monotonic() {
-#if defined(_WIN32)
-        return GetTickCount64();
-#else
-        struct timespec ti;
-        clock_gettime(CLOCK_MONOTONIC, &ti);
-        return (uint64_t)ti.tv_sec * 1000 + ti.tv_nsec / 1000000;
-#endif
-    }
-
     static uint64_t time_time() {
 #if defined(_WIN32)
         FILETIME f;
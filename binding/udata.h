@@ -1,6 +1,7 @@
 #pragma once
 
 #include <bee/nonstd/filesystem.h>
+#include <bee/utility/bytebuffer.h>
 #include <binding/binding.h>
 
 namespace bee::lua {
@@ -8,4 +9,8 @@ namespace bee::lua {
     struct udata<fs::path> {
         static inline auto name = "bee::path";
     };
+    template <>
+    struct udata<bytebuffer> {
+        static inline auto name = "bee::buffer";
+    };
 }
@@ -76,15 +76,24 @@ if supported "subprocess" then
         return ("package.cpath = [[%s]]"):format(table.concat(cpaths, ";"))
     end)()
 
-    function shell:runlua(script, option)
+    function shell:runlua(script, option, batch)
         option = option or {}
         local filename = option[1]
+        -- wrapper is a command prefix such as { "unshare", "-U" }.
+        local wrapper = option.wrapper or {}
+        option.wrapper = nil
         option[1] = {
+            wrapper,
             luaexe,
             "-e", initscript.."\n"..script.."\nos.exit(true)",
             filename
         }
-        local process, errmsg = subprocess.spawn(option)
+        local process, errmsg
+        if batch then
+            process, errmsg = batch:spawn(option)
+        else
+            process, errmsg = subprocess.spawn(option)
+        end
         lt.assertIsUserdata(process, errmsg)
         return process
     end
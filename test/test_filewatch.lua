@@ -2,7 +2,10 @@ local lt = require "ltest"
 local filewatch = require "bee.filewatch"
 local fs = require "bee.filesystem"
 local thread = require "bee.thread"
+local time = require "bee.time"
 local supported = require "supported"
+local platform = require "bee.platform"
+local shell = require "shell"
 
 local test_fw = lt.test "filewatch"
 
@@ -14,6 +17,21 @@ local function create_file(filename, content)
     end
 end
 
+-- fw:wait may return early, so keep waiting until something is queued or
+-- the generous deadline passes.
+local function wait_until(fw, sec)
+    local deadline = time.monotonic() + sec * 1000
+    while true do
+        local remaining = deadline - time.monotonic()
+        if remaining <= 0 then
+            return fw:wait(0)
+        end
+        if fw:wait(remaining / 1000) then
+            return true
+        end
+    end
+end
+
 local function test(f)
     local root = fs.absolute("./temp/"):lexically_normal()
     pcall(fs.remove_all, root)
@@ -74,6 +92,341 @@ function test_fw:test_2()
     end)
 end
 
+function test_fw:test_wait()
+    test(function (fw, root)
+        local fd = fw:fd()
+        if fd ~= nil then
+            lt.assertEquals(type(fd), "userdata")
+        end
+        lt.assertEquals(fw:wait(0), false)
+        local flags, paths = fw:select_many()
+        lt.assertEquals(flags, {})
+        lt.assertEquals(paths, {})
+        create_file(root / "test1.txt")
+        create_file(root / "test2.txt")
+        local list = {}
+        while fw:wait(0.1) do
+            local f, p = fw:select_many(1)
+            lt.assertEquals(#f, 1)
+            lt.assertEquals(#p, 1)
+            lt.assertIsString(f[1])
+            list[fs.path(p[1]):filename():string()] = true
+            if list["test1.txt"] and list["test2.txt"] then
+                break
+            end
+        end
+        lt.assertEquals(list["test1.txt"], true)
+        lt.assertEquals(list["test2.txt"], true)
+    end)
+end
+
+function test_fw:test_select_fd()
+    test(function (fw, root)
+        local fd = fw:fd()
+        if fd == nil then
+            return
+        end
+        local socket = require "bee.socket"
+        lt.assertEquals(fw:fd(), fd)
+        while fw:select() do
+        end
+        lt.assertEquals(socket.select({ fd }, nil, 0), {})
+        create_file(root / "test1.txt")
+        lt.assertEquals(socket.select({ fd }, nil, 5), { fd })
+        local found = false
+        for _ = 1, 100 do
+            local w, v = fw:select()
+            if w then
+                if fs.path(v):filename():string() == "test1.txt" then
+                    found = true
+                    break
+                end
+            else
+                thread.sleep(0.01)
+            end
+        end
+        lt.assertEquals(found, true)
+        -- the socket owns a duplicate; closing it leaves the watch working.
+        fd:close()
+        create_file(root / "test2.txt")
+        lt.assertEquals(fw:wait(5), true)
+    end)
+end
+
+function test_fw:test_coalesce()
+    test(function (fw, root)
+        -- a wide window, so every write below lands in the same one.
+        fw:set_quiet_period(0.5)
+        create_file(root / "tmp.txt", "x")
+        fs.remove(root / "tmp.txt")
+        create_file(root / "keep.txt")
+        for i = 1, 10 do
+            create_file(root / "keep.txt", tostring(i))
+        end
+        lt.assertEquals(wait_until(fw, 5), true)
+        local flags, paths = fw:select_many()
+        lt.assertEquals(#paths, 1)
+        lt.assertEquals(fs.path(paths[1]):filename():string(), "keep.txt")
+        lt.assertIsString(flags[1])
+    end)
+end
+
+function test_fw:test_quiet_period()
+    test(function (fw, root)
+        fw:set_quiet_period(0.3)
+        create_file(root / "test1.txt")
+        thread.sleep(0.01)
+        lt.assertEquals(fw:wait(0), false)
+        lt.assertEquals(wait_until(fw, 5), true)
+        local flags, paths = fw:select_many()
+        lt.assertEquals(#paths, 1)
+        lt.assertEquals(fs.path(paths[1]):filename():string(), "test1.txt")
+        lt.assertEquals(flags[1], "rename")
+    end)
+end
+
+function test_fw:test_quiet_period_max()
+    test(function (fw, root)
+        -- writes every 20ms never leave a 300ms gap; only the 600ms cap releases them.
+        create_file(root / "busy.txt")
+        lt.assertEquals(wait_until(fw, 5), true)
+        fw:select_many()
+        fw:set_quiet_period(0.3, 0.6)
+        local start = time.monotonic()
+        local delivered
+        while time.monotonic() - start < 5000 do
+            local f <close> = assert(io.open((root / "busy.txt"):string(), "ab"))
+            f:write "x"
+            if fw:wait(0) then
+                delivered = time.monotonic() - start
+                break
+            end
+            thread.sleep(0.02)
+        end
+        lt.assertNotEquals(delivered, nil)
+        lt.assertEquals(delivered >= 300, true)
+        local _, paths = fw:select_many()
+        lt.assertEquals(fs.path(paths[1]):filename():string(), "busy.txt")
+    end)
+end
+
+function test_fw:test_queue_limit()
+    test(function (fw, root)
+        fw:set_queue_limit(2)
+        for i = 1, 5 do
+            create_file(root / ("test%d.txt"):format(i))
+        end
+        lt.assertEquals(wait_until(fw, 5), true)
+        local flags, paths = fw:select_many()
+        lt.assertEquals(flags, { "overflow" })
+        lt.assertEquals(paths, { "" })
+        create_file(root / "after.txt")
+        lt.assertEquals(wait_until(fw, 5), true)
+        flags, paths = fw:select_many()
+        lt.assertEquals(fs.path(paths[1]):filename():string(), "after.txt")
+    end)
+end
+
+local function flood(path, n)
+    -- every open/close pair queues two inotify events that are never merged.
+    for _ = 1, n do
+        local f <close> = assert(io.open(path:string(), "rb"))
+    end
+end
+
+function test_fw:test_overflow()
+    if filewatch.type ~= "inotify" then
+        return
+    end
+    test(function (fw, root)
+        create_file(root / "old.txt")
+        create_file(root / "flood.txt")
+        fw:select_many()
+        lt.assertEquals(fw:set_rescan(true), true)
+        flood(root / "flood.txt", 10000)
+        create_file(root / "new.txt")
+        fs.remove(root / "old.txt")
+        local list = {}
+        while fw:wait(0.1) do
+            local flags, paths = fw:select_many()
+            for i = 1, #paths do
+                list[fs.path(paths[i]):filename():string()] = flags[i]
+            end
+        end
+        lt.assertEquals(list["new.txt"], "rename")
+        lt.assertEquals(list["old.txt"], "rename")
+
+        lt.assertEquals(fw:set_rescan(false), true)
+        flood(root / "flood.txt", 10000)
+        local flags = fw:select_many()
+        lt.assertEquals(flags[#flags], "overflow")
+    end)
+end
+
+function test_fw:test_tree()
+    local root = fs.absolute("./temp/"):lexically_normal()
+    pcall(fs.remove_all, root)
+    for i = 1, 40 do
+        fs.create_directories(root / ("dir%d"):format(i) / "a" / "b")
+    end
+    local fw <close> = filewatch.create()
+    fw:set_recursive(true)
+    fw:add(root:string())
+    create_file(root / "dir40" / "a" / "b" / "test.txt")
+    fs.remove_all(root / "dir1")
+    create_file(root / "dir2" / "a" / "test.txt")
+    local list = {}
+    while fw:wait(0.1) do
+        local _, paths = fw:select_many()
+        for i = 1, #paths do
+            list[fs.path(paths[i]):lexically_normal():string()] = true
+        end
+    end
+    lt.assertEquals(list[(root / "dir40" / "a" / "b" / "test.txt"):string()], true)
+    lt.assertEquals(list[(root / "dir1"):string()], true)
+    lt.assertEquals(list[(root / "dir2" / "a" / "test.txt"):string()], true)
+
+    -- directories made later join the tree under their parent, subdirectories included.
+    fs.create_directories(root / "dir3" / "late" / "a" / "b")
+    lt.assertEquals(wait_until(fw, 5), true)
+    create_file(root / "dir3" / "late" / "a" / "b" / "test.txt")
+    list = {}
+    while wait_until(fw, 5) do
+        local _, paths = fw:select_many()
+        for i = 1, #paths do
+            list[fs.path(paths[i]):lexically_normal():string()] = true
+        end
+        if list[(root / "dir3" / "late" / "a" / "b" / "test.txt"):string()] then
+            break
+        end
+    end
+    lt.assertEquals(list[(root / "dir3" / "late" / "a" / "b" / "test.txt"):string()], true)
+    pcall(fs.remove_all, root)
+end
+
+function test_fw:test_fanotify()
+    local fw <close> = filewatch.create "fanotify"
+    lt.assertEquals(filewatch.create():type(), filewatch.type)
+    if fw:type() ~= "fanotify" then
+        -- unprivileged or not Linux: the default backend is kept.
+        lt.assertEquals(fw:type(), filewatch.type)
+        return
+    end
+    local root = fs.absolute("./temp/"):lexically_normal()
+    pcall(fs.remove_all, root)
+    fs.create_directories(root)
+    fw:set_recursive(true)
+    fw:set_filter(function (path)
+        return fs.path(path):filename():string() ~= "skip"
+    end)
+    fw:add(root:string())
+    fs.create_directories(root / "a" / "b")
+    fs.create_directories(root / "skip")
+    create_file(root / "a" / "b" / "test.txt")
+    create_file(root / "skip" / "test.txt")
+    local list = {}
+    while fw:wait(0.1) do
+        local _, paths = fw:select_many()
+        for i = 1, #paths do
+            list[fs.path(paths[i]):lexically_normal():string()] = true
+        end
+    end
+    lt.assertEquals(list[(root / "a" / "b" / "test.txt"):string()], true)
+    lt.assertEquals(list[(root / "skip" / "test.txt"):string()], nil)
+    pcall(fs.remove_all, root)
+end
+
+function test_fw:test_fanotify_unprivileged()
+    if platform.os ~= "linux" or not supported "subprocess" or not fs.exists "/usr/bin/unshare" then
+        return
+    end
+    -- a fresh user namespace drops CAP_SYS_ADMIN in the initial one, where
+    -- fanotify_init may still succeed but filesystem marks are refused. The
+    -- fd is taken before add(), the way an event loop registers it.
+    local root = fs.absolute("./temp/"):lexically_normal()
+    pcall(fs.remove_all, root)
+    fs.create_directories(root)
+    local process = shell:runlua(([[
+        local filewatch = require "bee.filewatch"
+        local socket = require "bee.socket"
+        local fw <close> = filewatch.create "fanotify"
+        local fd = fw:fd()
+        fw:add %q
+        assert(fw:fd() == fd)
+        local f <close> = assert(io.open(%q, "wb"))
+        f:close()
+        local deadline = os.time() + 5
+        while os.time() < deadline do
+            if #socket.select({ fd }, nil, 1) > 0 then
+                for _ = 1, 100 do
+                    local w, path = fw:select()
+                    if w then
+                        io.write(fw:type(), " ", path)
+                        return
+                    end
+                end
+            end
+        end
+        io.write(fw:type(), " timeout")
+    ]]):format(root:string(), (root / "test.txt"):string()), { wrapper = { "/usr/bin/unshare", "-U" }, stdout = true })
+    local out = process.stdout:read "a"
+    local code = process:wait()
+    pcall(fs.remove_all, root)
+    if code ~= 0 and out == "" then
+        -- user namespaces are disabled here.
+        return
+    end
+    local backend, path = out:match "^(%S+) (.*)$"
+    lt.assertEquals(backend, filewatch.type)
+    lt.assertEquals(fs.path(path):lexically_normal():string(), (root / "test.txt"):string())
+end
+
+function test_fw:test_rules()
+    for _, backend in ipairs { "default", "fanotify" } do
+        local root = fs.absolute("./temp/"):lexically_normal()
+        pcall(fs.remove_all, root)
+        fs.create_directories(root / "old" / "build")
+        fs.create_directories(root / "a")
+        fs.create_directories(root / "build")
+        fs.create_directories(root / "src" / "x" / "y" / "gen")
+        local fw <close> = filewatch.create(backend)
+        fw:set_recursive(true)
+        lt.assertEquals(fw:set_filter {
+            "# comment",
+            "build/",
+            "*.log",
+            "!keep.log",
+            "/top.txt",
+            "src/**/gen",
+        }, true)
+        fw:add(root:string())
+        create_file(root / "old" / "build" / "x.txt")
+        create_file(root / "build" / "x.txt")
+        create_file(root / "a" / "b.log")
+        create_file(root / "a" / "keep.log")
+        create_file(root / "top.txt")
+        create_file(root / "a" / "top.txt")
+        create_file(root / "src" / "x" / "y" / "gen" / "g.txt")
+        create_file(root / "src" / "x" / "y" / "s.txt")
+        local list = {}
+        while fw:wait(0.1) do
+            local _, paths = fw:select_many()
+            for i = 1, #paths do
+                list[fs.path(paths[i]):lexically_normal():string()] = true
+            end
+        end
+        lt.assertEquals(list[(root / "old" / "build" / "x.txt"):string()], nil)
+        lt.assertEquals(list[(root / "build" / "x.txt"):string()], nil)
+        lt.assertEquals(list[(root / "a" / "b.log"):string()], nil)
+        lt.assertEquals(list[(root / "a" / "keep.log"):string()], true)
+        lt.assertEquals(list[(root / "top.txt"):string()], nil)
+        lt.assertEquals(list[(root / "a" / "top.txt"):string()], true)
+        lt.assertEquals(list[(root / "src" / "x" / "y" / "gen" / "g.txt"):string()], nil)
+        lt.assertEquals(list[(root / "src" / "x" / "y" / "s.txt"):string()], true)
+        pcall(fs.remove_all, root)
+    end
+end
+
 -- test unexist symlink link to self
 -- test directory symlink link to parent
 function test_fw:test_symlink()
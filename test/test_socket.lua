@@ -197,6 +197,696 @@ function test_socket:test_pair()
     server:close()
 end
 
+function test_socket:test_option()
+    local fd <close> = assert(socket "tcp")
+    lt.assertEquals(fd:option("nodelay", true), true)
+    lt.assertEquals(fd:getoption "nodelay" ~= 0, true)
+    lt.assertEquals(fd:option("nodelay", false), true)
+    lt.assertEquals(fd:getoption "nodelay", 0)
+    lt.assertEquals(fd:option("keepalive", 1), true)
+    lt.assertEquals(fd:getoption "keepalive" ~= 0, true)
+    lt.assertEquals(fd:option("reuseaddr", 1), true)
+    lt.assertEquals(fd:getoption "reuseaddr" ~= 0, true)
+    lt.assertEquals(fd:option("sndbuf", 65536), true)
+    lt.assertEquals(fd:getoption "sndbuf" > 0, true)
+    for _, name in ipairs { "keepidle", "keepintvl", "keepcnt", "reuseport", "cork", "tos" } do
+        local ok, err = fd:option(name, 8)
+        if ok then
+            lt.assertEquals(fd:getoption(name) > 0, true)
+        else
+            lt.assertIsString(err)
+        end
+    end
+    lt.assertError(fd.option, fd, "unknown", 1)
+end
+
+function test_socket:test_accept_many()
+    local server <close> = assert(socket "tcp")
+    lt.assertEquals(server:bind("127.0.0.1", 0), true)
+    lt.assertEquals(server:listen(), true)
+    local _, port = server:info "socket"
+    lt.assertEquals(server:accept_many(), false)
+    local clients = {}
+    for i = 1, 4 do
+        clients[i] = assert(socket "tcp")
+        clients[i]:connect("127.0.0.1", port)
+    end
+    local fds, addrs = {}, {}
+    while #fds < 4 do
+        socket.select({ server }, nil, 1)
+        local newfds, newaddrs = server:accept_many(4 - #fds, true)
+        if newfds then
+            lt.assertEquals(#newfds, #newaddrs)
+            table.move(newfds, 1, #newfds, #fds + 1, fds)
+            table.move(newaddrs, 1, #newaddrs, #addrs + 1, addrs)
+        end
+    end
+    for i = 1, 4 do
+        local ip, peerport = socket.endpoint_info(addrs[i])
+        lt.assertEquals(ip, "127.0.0.1")
+        lt.assertEquals(select(2, fds[i]:info "peer"), peerport)
+        fds[i]:close()
+        clients[i]:close()
+    end
+    lt.assertError(server.accept_many, server, 0)
+end
+
+function test_socket:test_framer()
+    local server, client = assert(socket.pair())
+    local tx = socket.framer(server, { header = "u16le" })
+    local rx = socket.framer(client, { header = "u16le" })
+    lt.assertEquals(rx:recv(), false)
+    lt.assertEquals(tx:send("hello", "", "world"), true)
+    local frames = {}
+    while #frames < 3 do
+        socket.select({ client }, nil)
+        table.move(rx:recv(), 1, 3, #frames + 1, frames)
+    end
+    lt.assertEquals(frames, { "hello", "", "world" })
+    lt.assertEquals(syncSend(server, "\5\0ab"), true)
+    socket.select({ client }, nil)
+    lt.assertEquals(rx:recv(), {})
+    lt.assertEquals(syncSend(server, "cde\1\0"), true)
+    socket.select({ client }, nil)
+    lt.assertEquals(rx:recv(), { "abcde" })
+    lt.assertEquals(syncSend(server, "f"), true)
+    socket.select({ client }, nil)
+    lt.assertEquals(rx:recv(), { "f" })
+
+    local line_tx = socket.framer(server, { delimiter = "\r\n" })
+    local line_rx = socket.framer(client, { delimiter = "\r\n", max = 8 })
+    lt.assertEquals(line_tx:send("a", "bc"), true)
+    socket.select({ client }, nil)
+    lt.assertEquals(line_rx:recv(), { "a", "bc" })
+    lt.assertEquals(syncSend(server, "toolongline"), true)
+    socket.select({ client }, nil)
+    lt.assertEquals({ line_rx:recv() }, { nil, "frame too large" })
+    -- the rest of the oversized line is dropped and the stream carries on.
+    lt.assertEquals(syncSend(server, "ine\r\nok\r\n"), true)
+    socket.select({ client }, nil)
+    lt.assertEquals(line_rx:recv(), { "ok" })
+    lt.assertEquals(syncSend(server, "cd\r\n123456789\r\nef\r\n"), true)
+    socket.select({ client }, nil)
+    lt.assertEquals(line_rx:recv(), { "cd" })
+    lt.assertEquals({ line_rx:recv() }, { nil, "frame too large" })
+    lt.assertEquals(line_rx:recv(), { "ef" })
+    lt.assertEquals(line_rx:recv(), false)
+    lt.assertError(line_rx.send, line_rx, "123456789")
+
+    local small_rx = socket.framer(client, { header = "u16le", max = 4 })
+    lt.assertEquals(syncSend(server, "\6\0abc"), true)
+    socket.select({ client }, nil)
+    lt.assertEquals({ small_rx:recv() }, { nil, "frame too large" })
+    lt.assertEquals(syncSend(server, "def\2\0hi"), true)
+    socket.select({ client }, nil)
+    lt.assertEquals(small_rx:recv(), { "hi" })
+
+    local big_tx = socket.framer(server, {})
+    local big_rx = socket.framer(client, {})
+    local big = ("x"):rep(1024 * 1024)
+    local done = big_tx:send(big)
+    frames = {}
+    while not done do
+        lt.assertEquals(big_tx:pending() > 0, true)
+        socket.select({ client }, nil)
+        table.move(big_rx:recv(), 1, 1, 1, frames)
+        done = big_tx:flush()
+    end
+    lt.assertEquals(big_tx:pending(), 0)
+    server:close()
+    while true do
+        socket.select({ client }, nil)
+        local r = big_rx:recv()
+        if r == nil then
+            break
+        end
+        table.move(r, 1, 1, 1, frames)
+    end
+    lt.assertEquals(frames[1] == big, true)
+    client:close()
+    lt.assertError(tx.send, tx, "closed")
+    lt.assertError(socket.framer, client, { header = "u64" })
+end
+
+function test_socket:test_timer()
+    local time = require "bee.time"
+    local timer = socket.timer()
+    lt.assertEquals(timer:timeout(), nil)
+    lt.assertEquals(timer:expire(), {})
+    local a = timer:add(20, "a")
+    local b = timer:add(20, "b")
+    local c = timer:add(60000, "c")
+    lt.assertEquals(#timer, 3)
+    lt.assertEquals(timer:timeout() <= 20, true)
+    lt.assertEquals(timer:cancel(b), true)
+    lt.assertEquals(timer:cancel(b), false)
+    lt.assertEquals(timer:reset(c, 40), true)
+    local start = time.monotonic()
+    local fired = {}
+    while #fired < 2 do
+        local rd = socket.select(nil, nil, timer)
+        lt.assertEquals(rd, {})
+        for _, v in ipairs(timer:expire()) do
+            fired[#fired + 1] = v
+        end
+    end
+    lt.assertEquals(fired, { "a", "c" })
+    lt.assertEquals(time.monotonic() - start >= 40, true)
+    lt.assertEquals(#timer, 0)
+    lt.assertEquals(timer:reset(a, 10), false)
+    lt.assertEquals(timer:cancel(c), false)
+    for i = 1, 3 do
+        timer:add(0, i)
+    end
+    thread.sleep(0.01)
+    lt.assertEquals(#timer:expire(2), 2)
+    lt.assertEquals(#timer:expire(), 1)
+end
+
+function test_socket:test_timer_cascade()
+    local time = require "bee.time"
+    local timer = socket.timer()
+    -- taken before add(), which reads the clock itself, so a millisecond
+    -- tick in between cannot make the timer look early.
+    local start = time.monotonic()
+    -- past the 256ms lowest level, so it fires through a cascade.
+    timer:add(300, "late")
+    timer:add(60000, "never")
+    local fired
+    repeat
+        socket.select(nil, nil, timer)
+        fired = timer:expire()
+    until #fired > 0
+    lt.assertEquals(fired, { "late" })
+    lt.assertEquals(time.monotonic() - start >= 300, true)
+    lt.assertEquals(#timer, 1)
+end
+
+function test_socket:test_sendfd()
+    fs.remove(TestUnixSock)
+    local server <close> = assert(socket "unix")
+    lt.assertEquals(server:bind(TestUnixSock), true)
+    lt.assertEquals(server:listen(), true)
+    local master <close> = assert(socket "unix")
+    master:connect(TestUnixSock)
+    socket.select({ server }, nil)
+    local worker <close> = assert(server:accept())
+    socket.select(nil, { master })
+    local upstream, downstream = assert(socket.pair())
+    lt.assertError(master.sendfd, master, upstream)
+    lt.assertError(master.sendfd, master, upstream, "")
+    local n, err = master:sendfd(upstream, "conn")
+    if not n then
+        lt.assertIsString(err)
+        return
+    end
+    lt.assertEquals(n, 4)
+    socket.select({ worker }, nil)
+    local data, passed = worker:recvfd()
+    lt.assertEquals(data, "conn")
+    lt.assertIsUserdata(passed)
+    upstream:close()
+    lt.assertEquals(syncSend(passed, "ping"), true)
+    lt.assertEquals(syncRecv(downstream, 4), "ping")
+    passed:close()
+    downstream:close()
+    lt.assertEquals(master:send "plain", 5)
+    socket.select({ worker }, nil)
+    lt.assertEquals({ worker:recvfd() }, { "plain" })
+    local cred = worker:peercred()
+    if cred then
+        lt.assertIsNumber(cred.uid)
+        lt.assertIsNumber(cred.gid)
+    end
+    master:close()
+    socket.select({ worker }, nil)
+    lt.assertEquals(worker:recvfd(), nil)
+end
+
+function test_socket:test_pool()
+    local server <close> = assert(socket "tcp")
+    lt.assertEquals(server:bind("127.0.0.1", 0), true)
+    lt.assertEquals(server:listen(), true)
+    local _, port = server:info "socket"
+    local pool <close> = socket.pool { max = 2 }
+    local function checkout()
+        local fd, state = pool:checkout("127.0.0.1", port)
+        if not fd then
+            return fd, state
+        end
+        if state == "connecting" then
+            socket.select(nil, { fd })
+            lt.assertEquals(fd:status(), true)
+        end
+        return fd, state
+    end
+    local c1, state1 = checkout()
+    lt.assertIsUserdata(c1)
+    lt.assertEquals(state1 ~= "reused", true)
+    socket.select({ server }, nil)
+    local s1 = assert(server:accept())
+    local _, local_port = c1:info "socket"
+    lt.assertEquals(pool:checkin(c1), true)
+    lt.assertError(c1.send, c1, "x")
+    lt.assertEquals(pool:stats(), { idle = 1, active = 0 })
+
+    local c2, state2 = checkout()
+    lt.assertEquals(state2, "reused")
+    lt.assertEquals(select(2, c2:info "socket"), local_port)
+    local c3 = checkout()
+    socket.select({ server }, nil)
+    local s3 = assert(server:accept())
+    lt.assertEquals(pool:checkout("127.0.0.1", port), false)
+    lt.assertEquals(pool:stats(), { idle = 0, active = 2 })
+
+    lt.assertEquals(pool:checkin(c3, false), true)
+    lt.assertEquals(pool:checkin(c2), true)
+    s1:close()
+    s3:close()
+    socket.select({ server }, nil, 0.01)
+    local c4, state4 = checkout()
+    lt.assertEquals(state4 ~= "reused", true)
+    lt.assertEquals(pool:stats(), { idle = 0, active = 1 })
+    local other = assert(socket "tcp")
+    lt.assertEquals(pool:checkin(other), false)
+    other:close()
+    -- closing without checkin is noticed, and a socket that reuses the
+    -- descriptor number is not mistaken for the pooled one.
+    c4:close()
+    local reused = assert(socket "tcp")
+    lt.assertEquals(pool:checkin(reused), false)
+    lt.assertEquals(reused:status(), true)
+    lt.assertEquals(pool:stats(), { idle = 0, active = 0 })
+    reused:close()
+    lt.assertEquals(pool:evict(), 0)
+
+    -- a host at its limit looks for connections closed without checkin.
+    local c5 = checkout()
+    local c6 = checkout()
+    lt.assertEquals(pool:checkout("127.0.0.1", port), false)
+    c5:close()
+    c6:close()
+    local c7 = checkout()
+    lt.assertIsUserdata(c7)
+    lt.assertEquals(pool:stats(), { idle = 0, active = 1 })
+    lt.assertEquals(pool:checkin(c7, false), true)
+end
+
+function test_socket:test_conntable()
+    local server <close> = assert(socket "tcp")
+    lt.assertEquals(server:bind("127.0.0.1", 0), true)
+    lt.assertEquals(server:listen(), true)
+    local _, port = server:info "socket"
+    local conns <close> = socket.conntable { slots = 2 }
+    lt.assertEquals(conns:accept(server), false)
+    local client = assert(socket "tcp")
+    client:connect("127.0.0.1", port)
+    socket.select({ server }, nil)
+    local ids = conns:accept(server)
+    lt.assertEquals(#ids, 1)
+    local sid = ids[1]
+    socket.select(nil, { client })
+    lt.assertEquals(client:status(), true)
+    local cid = conns:add(client)
+    lt.assertError(client.send, client, "x")
+    lt.assertEquals(#conns, 2)
+
+    lt.assertEquals(conns:get(sid, 1), 0)
+    conns:set(sid, 2, 42)
+    lt.assertEquals(conns:get(sid, 2), 42)
+    lt.assertError(conns.get, conns, sid, 3)
+
+    lt.assertEquals(conns:recv(sid), false)
+    lt.assertEquals(conns:send(cid, "hello"), true)
+    local rd = conns:wait()
+    lt.assertEquals(rd, { sid })
+    lt.assertEquals(conns:recv(sid), 5)
+    lt.assertEquals({ conns:pending(sid) }, { 0, 5 })
+    lt.assertEquals(conns:read(sid, 2), "he")
+    lt.assertEquals(conns:read(sid), "llo")
+    lt.assertEquals(conns:read(sid), "")
+
+    local fd = conns:detach(cid)
+    lt.assertIsUserdata(fd)
+    lt.assertError(conns.recv, conns, cid)
+    lt.assertEquals(#conns, 1)
+    fd:close()
+    conns:wait()
+    lt.assertEquals(conns:recv(sid), nil)
+    lt.assertEquals(conns:close(sid), true)
+    lt.assertEquals(conns:close(sid), false)
+    lt.assertEquals(#conns, 0)
+    lt.assertEquals({ conns:wait(0) }, { {}, {} })
+    lt.assertEquals({ conns:wait(0.01) }, { {}, {} })
+    lt.assertError(conns.wait, conns)
+    local reused = conns:add(assert(socket "tcp"))
+    lt.assertEquals(reused ~= sid, true)
+    lt.assertEquals(conns:get(reused, 2), 0)
+end
+
+function test_socket:test_stats()
+    local before = socket.stats(true)
+    local server <close> = assert(socket "tcp")
+    lt.assertEquals(server:bind("127.0.0.1", 0), true)
+    lt.assertEquals(server:listen(), true)
+    local _, port = server:info "socket"
+    local client <close> = assert(socket "tcp")
+    client:connect("127.0.0.1", port)
+    socket.select({ server }, nil)
+    local session <close> = assert(server:accept())
+    socket.select(nil, { client })
+    lt.assertEquals(client:status(), true)
+    lt.assertEquals(session:recv(), false)
+    lt.assertEquals(syncSend(client, "hello"), true)
+    lt.assertEquals(syncRecv(session, 5), "hello")
+    local cs = client:stats()
+    lt.assertEquals(cs.bytes_out, 5)
+    lt.assertEquals(cs.connects, 1)
+    lt.assertEquals(cs.connect_time >= 0, true)
+    local ss = session:stats()
+    lt.assertEquals(ss.bytes_in, 5)
+    lt.assertEquals(ss.wait_in >= 1, true)
+    local after = socket.stats(false)
+    lt.assertEquals(after.bytes_out - before.bytes_out >= 5, true)
+    lt.assertEquals(after.syscalls > before.syscalls, true)
+    lt.assertEquals(after.connects > before.connects, true)
+    lt.assertEquals(client:stats(), nil)
+    local info, err = client:tcpinfo()
+    if info then
+        lt.assertIsNumber(info.rtt)
+        lt.assertEquals(info.snd_cwnd > 0, true)
+    else
+        lt.assertIsString(err)
+    end
+end
+
+function test_socket:test_stats_reuse()
+    socket.stats(true)
+    local server <close> = assert(socket "tcp")
+    lt.assertEquals(server:bind("127.0.0.1", 0), true)
+    lt.assertEquals(server:listen(), true)
+    local _, port = server:info "socket"
+    local a = assert(socket "tcp")
+    a:connect("127.0.0.1", port)
+    lt.assertEquals(a:stats().syscalls, 1)
+    local fd = a:handle()
+    a:close()
+    -- a new socket that reuses the descriptor starts without counters.
+    local b <close> = assert(socket "tcp")
+    lt.assertEquals(b:handle(), fd)
+    lt.assertEquals(b:stats(), nil)
+    socket.stats(false)
+end
+
+function test_socket:test_listen_group()
+    local group, err = socket.listen_group("tcp", "127.0.0.1", 0, 2)
+    if not group then
+        lt.assertIsString(err)
+        return
+    end
+    lt.assertEquals(#group, 2)
+    local _, port = group[1]:info "socket"
+    local _, port2 = group[2]:info "socket"
+    lt.assertEquals(port, port2)
+    local clients = {}
+    for i = 1, 8 do
+        clients[i] = assert(socket "tcp")
+        clients[i]:connect("127.0.0.1", port)
+    end
+    local accepted = 0
+    while accepted < 8 do
+        local rd = socket.select(group, nil, 1)
+        lt.assertEquals(#rd > 0, true)
+        for _, fd in ipairs(rd) do
+            local newfd = fd:accept()
+            if newfd then
+                newfd:close()
+                accepted = accepted + 1
+            end
+        end
+    end
+    for _, fd in ipairs(clients) do
+        fd:close()
+    end
+    for _, fd in ipairs(group) do
+        fd:close()
+    end
+    lt.assertError(socket.listen_group, "unix", "test.sock", 0, 2)
+end
+
+function test_socket:test_listen_group_threads()
+    local group = socket.listen_group("tcp", "127.0.0.1", 0, 2)
+    if not group then
+        return
+    end
+    local _, port = group[1]:info "socket"
+    thread.newchannel "listen_group_accepted"
+    thread.newchannel "listen_group_quit"
+    local accepted = thread.channel "listen_group_accepted"
+    local quit = thread.channel "listen_group_quit"
+    local workers = {}
+    for i, fd in ipairs(group) do
+        workers[i] = thread.thread([[
+            local fd, index = ...
+            local socket = require "bee.socket"
+            local thread = require "bee.thread"
+            local accepted = thread.channel "listen_group_accepted"
+            local quit = thread.channel "listen_group_quit"
+            local listener = socket.fd(fd)
+            while not quit:pop() do
+                local rd = socket.select({ listener }, nil, 0.05)
+                if rd and rd[1] then
+                    local session = listener:accept()
+                    if session then
+                        session:close()
+                        accepted:push(index)
+                    end
+                end
+            end
+            listener:close()
+        ]], fd:detach(), i)
+    end
+    -- each connection has its own source port, so the kernel hash spreads
+    -- them over both listeners; all 64 landing on one is a 2^-63 chance.
+    local clients = {}
+    for i = 1, 64 do
+        clients[i] = assert(socket "tcp")
+        clients[i]:connect("127.0.0.1", port)
+    end
+    local counts = { 0, 0 }
+    for _ = 1, 64 do
+        local index = accepted:bpop()
+        counts[index] = counts[index] + 1
+    end
+    lt.assertEquals(counts[1] > 0, true)
+    lt.assertEquals(counts[2] > 0, true)
+    for _ = 1, #workers do
+        quit:push(true)
+    end
+    for _, w in ipairs(workers) do
+        thread.wait(w)
+    end
+    for _, fd in ipairs(clients) do
+        fd:close()
+    end
+    assertNotThreadError()
+end
+
+function test_socket:test_vectored()
+    local server, client = assert(socket.pair())
+    lt.assertEquals(client:sendv { "\0\5", "hello", "", "world" }, 12)
+    local rd = socket.select({ server }, nil)
+    lt.assertEquals(rd[1], server)
+    lt.assertEquals(server:recvv { 2, 5, 8 }, { "\0\5", "hello", "world" })
+    lt.assertErrorMsgEquals([[bad argument #2 to '?' (invalid number of buffers)]], client.sendv, client, {})
+    client:close()
+    lt.assertEquals(server:recvv { 4 }, nil)
+    server:close()
+end
+
+function test_socket:test_buffer()
+    local buf = socket.buffer(8)
+    lt.assertEquals(#buf, 0)
+    buf:write("GET / HTTP/1.1\r\n", "Host: a\r\n\r\nbody")
+    lt.assertEquals(buf:find "\r\n\r\n", 24)
+    lt.assertEquals(buf:readline "\r\n", "GET / HTTP/1.1")
+    lt.assertEquals(buf:readline("\r\n", true), "Host: a\r\n")
+    lt.assertEquals(buf:readline "\r\n", "")
+    lt.assertEquals(buf:readline "\r\n", nil)
+    lt.assertEquals(buf:read(5), nil)
+    lt.assertEquals(buf:peek(2), "bo")
+    lt.assertEquals(buf:read(4), "body")
+    lt.assertEquals(#buf, 0)
+    buf:write "12345"
+    buf:skip(2):compact()
+    lt.assertEquals(buf:read(), "345")
+end
+
+function test_socket:test_recv_into()
+    local server, client = assert(socket.pair())
+    local buf = socket.buffer()
+    lt.assertEquals(server:recv_into(buf), false)
+    syncSend(client, "line1\nline2\npart")
+    local n = 0
+    while n < 16 do
+        socket.select({ server }, nil)
+        n = n + server:recv_into(buf)
+    end
+    lt.assertEquals(buf:readline(), "line1")
+    lt.assertEquals(buf:readline(), "line2")
+    lt.assertEquals(buf:readline(), nil)
+    lt.assertEquals(buf:read(), "part")
+    client:close()
+    lt.assertEquals(server:recv_into(buf), nil)
+    server:close()
+end
+
+function test_socket:test_mmsg()
+    local server = lt.assertIsUserdata(socket "udp")
+    lt.assertIsBoolean(server:bind("127.0.0.1", 0))
+    local _, port = server:info("socket")
+    local client = lt.assertIsUserdata(socket "udp")
+    lt.assertIsBoolean(client:bind("127.0.0.1", 0))
+    local _, cport = client:info("socket")
+    local addr = socket.endpoint("127.0.0.1", port)
+    lt.assertEquals({ socket.endpoint_info(addr) }, { "127.0.0.1", port })
+    lt.assertEquals(server:recvmmsg(), false)
+    lt.assertEquals(client:sendmmsg { { "a", addr }, { "bb", addr }, { "ccc", addr } }, 3)
+    local datas, addrs = {}, {}
+    while #datas < 3 do
+        socket.select({ server }, nil)
+        local d, a = server:recvmmsg(8)
+        for i = 1, #d do
+            datas[#datas+1] = d[i]
+            addrs[#addrs+1] = a[i]
+        end
+    end
+    lt.assertEquals(datas, { "a", "bb", "ccc" })
+    lt.assertEquals({ socket.endpoint_info(addrs[1]) }, { "127.0.0.1", cport })
+    lt.assertEquals(addrs[1], addrs[3])
+    client:close()
+    server:close()
+end
+
+function test_socket:test_sendfile()
+    local content = ("0123456789"):rep(1000)
+    do
+        local f <close> = assert(io.open("test_sendfile.txt", "wb"))
+        f:write(content)
+    end
+    local server, client = assert(socket.pair())
+    local offset = 0
+    local received = ""
+    while offset < #content do
+        local n = server:sendfile("test_sendfile.txt", offset, #content - offset)
+        if n then
+            offset = offset + n
+        end
+        local data = client:recv(#content)
+        if data then
+            received = received..data
+        end
+    end
+    while #received < #content do
+        socket.select({ client }, nil)
+        received = received..client:recv(#content)
+    end
+    lt.assertEquals(received, content)
+    local f <close> = assert(io.open("test_sendfile.txt", "rb"))
+    lt.assertEquals(server:sendfile(f, 5, 3), 3)
+    socket.select({ client }, nil)
+    lt.assertEquals(client:recv(), "567")
+    -- stopping at the end of the file is not a partial write.
+    local before = socket.stats(true)
+    lt.assertEquals(server:sendfile(f, #content - 2), 2)
+    lt.assertEquals(socket.stats(false).partial_writes, before.partial_writes)
+    socket.select({ client }, nil)
+    lt.assertEquals(client:recv(), "89")
+    f:close()
+    client:close()
+    server:close()
+    fs.remove "test_sendfile.txt"
+end
+
+function test_socket:test_splice()
+    local rd, wr = socket.pipe()
+    if not rd then
+        return
+    end
+    local server, client = assert(socket.pair())
+    local upstream, downstream = assert(socket.pair())
+    lt.assertEquals(syncSend(client, "proxy"), true)
+    socket.select({ server }, nil)
+    local n, err = server:splice(wr)
+    if not n and err:match "%(generic:95%)" then
+        return
+    end
+    lt.assertEquals(n, 5)
+    lt.assertEquals(rd:splice(upstream), 5)
+    lt.assertEquals(syncRecv(downstream, 5), "proxy")
+    client:close()
+    lt.assertEquals(server:splice(wr), nil)
+    for _, fd in ipairs { server, upstream, downstream, rd, wr } do
+        fd:close()
+    end
+end
+
+function test_socket:test_resolver()
+    do
+        local f <close> = assert(io.open("test_hosts.txt", "wb"))
+        f:write "# comment\n127.0.0.1 stub.test alias.test # trailing\n\n::1\tstub6.test\nlocalhost named.test\n"
+    end
+    local r <close> = assert(socket.resolver { threads = 2, ttl = 10, hosts = "test_hosts.txt" })
+    fs.remove "test_hosts.txt"
+    r:add_host("added.test", "127.0.0.2")
+    lt.assertError(r.add_host, r, "named.test", "localhost")
+    local fd = r:fd()
+    lt.assertEquals(r:fd(), fd)
+    local expected = {
+        [r:query("stub.test", 80)] = { "127.0.0.1", 80 },
+        [r:query("alias.test", 81)] = { "127.0.0.1", 81 },
+        [r:query("added.test", 82)] = { "127.0.0.2", 82 },
+        [r:query("127.0.0.3", 83)] = { "127.0.0.3", 83 },
+    }
+    local done = 0
+    while done < 4 do
+        local rd = socket.select({ fd }, nil, 1)
+        lt.assertEquals(#rd, 1)
+        for _, res in ipairs(r:results()) do
+            local e = expected[res.id]
+            lt.assertEquals(res.error, nil)
+            lt.assertEquals(res.ip, e[1])
+            lt.assertEquals(res.port, e[2])
+            lt.assertEquals({ socket.endpoint_info(res.addr) }, e)
+            done = done + 1
+        end
+    end
+    lt.assertEquals(r:results(), {})
+    r:close()
+    lt.assertError(r.query, r, "stub.test", 80)
+end
+
+function test_socket:test_resolver_error()
+    local time = require "bee.time"
+    local r <close> = assert(socket.resolver { threads = 1 })
+    local fd = r:fd()
+    local id = r:query("bee-no-such-host.invalid", 80)
+    local res
+    repeat
+        socket.select({ fd }, nil, 5)
+        res = r:results()
+    until #res > 0
+    lt.assertEquals(res[1].id, id)
+    lt.assertEquals(res[1].addr, nil)
+    lt.assertIsString(res[1].error)
+    lt.assertNotEquals(res[1].error, "cannot resolve host")
+    -- close must not wait for lookups still in getaddrinfo.
+    r:query("bee-no-such-host-2.invalid", 80)
+    local t = time.monotonic()
+    r:close()
+    lt.assertEquals(time.monotonic() - t < 100, true)
+end
+
 local function createEchoThread(name, ...)
     return thread.thread(([[
     -- %s
@@ -360,3 +1050,110 @@ function test_socket:test_SIGPIPE()
     end
     client:close()
 end
+
+local function waitUring(ring, n)
+    local res = {}
+    while #res < n do
+        for _, c in ipairs(ring:wait()) do
+            res[#res+1] = c
+        end
+    end
+    return res
+end
+
+function test_socket:test_uring()
+    local ring = socket.uring(64)
+    if not ring then
+        return
+    end
+    local server = lt.assertIsUserdata(socket "tcp")
+    lt.assertIsBoolean(server:bind("127.0.0.1", 0))
+    lt.assertIsBoolean(server:listen())
+    local _, port = server:info("socket")
+    local client = lt.assertIsUserdata(socket "tcp")
+    lt.assertEquals(ring:accept(server, 1), true)
+    lt.assertEquals(ring:connect(client, 2, "127.0.0.1", port), true)
+    local res = waitUring(ring, 2)
+    table.sort(res, function (a, b) return a.token < b.token end)
+    lt.assertEquals(res[1].error, nil)
+    lt.assertEquals(res[2].error, nil)
+    local session = lt.assertIsUserdata(res[1].result)
+    lt.assertEquals(res[2].result, true)
+
+    lt.assertEquals(ring:send(client, 3, "hello"), true)
+    lt.assertEquals(ring:send(client, 4, "world"), true)
+    lt.assertEquals(#waitUring(ring, 2), 2)
+    local data = ""
+    while #data < 10 do
+        lt.assertEquals(ring:recv(session, 5, 10 - #data), true)
+        local c = waitUring(ring, 1)[1]
+        lt.assertEquals(c.token, 5)
+        data = data..c.result
+    end
+    lt.assertEquals(data, "helloworld")
+
+    client:close()
+    lt.assertEquals(ring:recv(session, 6), true)
+    local c = waitUring(ring, 1)[1]
+    lt.assertEquals(c.token, 6)
+    lt.assertEquals(c.result, nil)
+    lt.assertEquals(c.error, nil)
+
+    session:close()
+    server:close()
+    ring:close()
+end
+
+function test_socket:test_uring_close()
+    local ring = socket.uring(8)
+    if not ring then
+        return
+    end
+    local a, b = socket.pair()
+    -- a bad argument must not leave a slot marked busy, or wait would block.
+    lt.assertError(ring.recv, ring, a)
+    lt.assertError(ring.recv, ring, a, "token")
+    lt.assertEquals(ring:wait(), {})
+    -- reads still in flight are cancelled and reaped before the ring goes away.
+    lt.assertEquals(ring:recv(a, 1), true)
+    lt.assertEquals(ring:recv(b, 2), true)
+    lt.assertEquals(ring:submit(), 2)
+    ring:close()
+    lt.assertError(ring.wait, ring)
+    a:close()
+    b:close()
+
+    -- more idle reads than submission entries: the cancels take several rounds.
+    local small = socket.uring(4)
+    local c, d = socket.pair()
+    for i = 1, 8 do
+        lt.assertEquals(small:recv(i % 2 == 0 and c or d, i), true)
+        if i % 4 == 0 then
+            lt.assertEquals(small:submit(), 4)
+        end
+    end
+    small:close()
+    c:close()
+    d:close()
+end
+
+function test_socket:test_uring_file()
+    local ring = socket.uring(8)
+    if not ring then
+        return
+    end
+    ring:register_buffers(2, 16)
+    local f <close> = assert(io.open("test_uring.txt", "w+b"))
+    lt.assertEquals(ring:write(f, 1, "0123456789", 0), true)
+    local c = waitUring(ring, 1)[1]
+    lt.assertEquals(c.result, 10)
+    lt.assertEquals(ring:read(f, 2, 4, 3), true)
+    lt.assertEquals(ring:read(f, 3, 32, 0), true)
+    local res = waitUring(ring, 2)
+    table.sort(res, function (a, b) return a.token < b.token end)
+    lt.assertEquals(res[1].result, "3456")
+    lt.assertEquals(res[2].result, "0123456789")
+    ring:close()
+    f:close()
+    fs.remove "test_uring.txt"
+end
@@ -4,6 +4,7 @@ local subprocess = require "bee.subprocess"
 local thread = require "bee.thread"
 local platform = require "bee.platform"
 local fs = require "bee.filesystem"
+local socket = require "bee.socket"
 local shell = require "shell"
 
 local function testArgs(...)
@@ -289,6 +290,52 @@ function test_subprocess:test_env()
     test_env('os.getenv "BEE_TEST_ENV_1" == nil', { BEE_TEST_ENV_1 = false })
 end
 
+function test_subprocess:test_batch()
+    local batch = subprocess.batch { env = { BEE_TEST = "ok", BEE_TEST_ENV_1 = false } }
+    subprocess.setenv("BEE_TEST_ENV_1", "OK")
+    for _ = 1, 3 do
+        local process = shell:runlua([[
+            assert(os.getenv "BEE_TEST" == "ok")
+            assert(os.getenv "BEE_TEST_ENV_1" == nil)
+        ]], {}, batch)
+        lt.assertEquals(process:wait(), 0)
+    end
+    lt.assertError(batch.spawn, batch, { "sh", env = {} })
+    if platform.os ~= "windows" then
+        -- bare names are looked up in PATH once and then reused.
+        for _ = 1, 3 do
+            local process = batch:spawn { "sh", "-c", "exit 3" }
+            lt.assertEquals(process:wait(), 3)
+        end
+        lt.assertEquals(batch:spawn { "bee-no-such-program" }, nil)
+
+        -- a relative PATH entry ahead of an absolute match keeps its priority.
+        local root = fs.absolute("test_batch_path"):lexically_normal()
+        pcall(fs.remove_all, root)
+        fs.create_directories(root / "rel")
+        fs.create_directories(root / "abs")
+        for dir, code in pairs { rel = 7, abs = 5 } do
+            local filename = (root / dir / "bee-shadow"):string()
+            local f <close> = assert(io.open(filename, "wb"))
+            f:write(("#!/bin/sh\nexit %d\n"):format(code))
+            f:close()
+            fs.permissions(fs.path(filename), 0x1ed)
+        end
+        -- like posix_spawnp, the batch searches the PATH of this process.
+        local oldpath = os.getenv "PATH"
+        subprocess.setenv("PATH", "rel:"..(root / "abs"):string())
+        local shadowed = subprocess.batch {}
+        local codes = {}
+        for i = 1, 2 do
+            local process = shadowed:spawn { "bee-shadow", cwd = root:string() }
+            codes[i] = process and process:wait()
+        end
+        subprocess.setenv("PATH", oldpath)
+        pcall(fs.remove_all, root)
+        lt.assertEquals(codes, { 7, 7 })
+    end
+end
+
 function test_subprocess:test_args()
     testArgs("A")
     testArgs("A", "B")
@@ -349,16 +396,125 @@ function test_subprocess:test_select()
         ]]
     end
     while #process_set > 0 do
-        local ok = subprocess.select(process_set)
-        lt.assertEquals(ok, true)
-        local i = 1
-        while i <= #process_set do
-            local process = process_set[i]
-            if process:is_running() then
-                i = i + 1
-            else
-                table.remove(process_set, i)
+        local exited = subprocess.select(process_set)
+        lt.assertIsTable(exited)
+        lt.assertEquals(#exited > 0, true)
+        for _, process in ipairs(exited) do
+            lt.assertEquals(process:is_running(), false)
+            lt.assertEquals(process:wait(), 0)
+            for i = 1, #process_set do
+                if process_set[i] == process then
+                    table.remove(process_set, i)
+                    break
+                end
+            end
+        end
+    end
+end
+
+function test_subprocess:test_select_timeout()
+    local process = shell:runlua([[
+        io.read "a"
+    ]], { stdin = true })
+    lt.assertEquals(subprocess.select({ process }, 10), {})
+    lt.assertEquals(process:is_running(), true)
+    process.stdin:close()
+    lt.assertEquals(subprocess.select({ process }), { process })
+    lt.assertEquals(process:wait(), 0)
+end
+
+function test_subprocess:test_async_pipe()
+    if platform.os == "windows" then
+        return
+    end
+    local process = shell:runlua([[
+        io.write(io.read "a")
+        io.stderr:write "err"
+    ]], { stdin = "async", stdout = "async", stderr = "async" })
+    lt.assertEquals(type(process.stdout:fd()), "userdata")
+    lt.assertEquals(process.stdout:read(), false)
+    lt.assertEquals(process.stdin:write "hello", 5)
+    process.stdin:close()
+    local out = {}
+    lt.assertEquals(process.stdout:fd(), process.stdout:fd())
+    local rd = { process.stdout:fd(), process.stderr:fd() }
+    local pipes = { [rd[1]] = process.stdout, [rd[2]] = process.stderr }
+    while next(pipes) do
+        local ready = socket.select(rd)
+        for _, s in ipairs(ready) do
+            local pipe = pipes[s]
+            local data = pipe:read()
+            if data == nil then
+                pipes[s] = nil
+                for i = 1, #rd do
+                    if rd[i] == s then
+                        table.remove(rd, i)
+                        break
+                    end
+                end
+                pipe:close()
+            elseif data then
+                out[pipe] = (out[pipe] or "") .. data
             end
         end
     end
+    lt.assertEquals(out[process.stdout], "hello")
+    lt.assertEquals(out[process.stderr], "err")
+    lt.assertEquals(process:wait(), 0)
+end
+
+function test_subprocess:test_fd()
+    local process = shell:runlua [[
+    ]]
+    local fd = process:fd()
+    if fd == nil then
+        lt.assertEquals(process:wait(), 0)
+        return
+    end
+    lt.assertEquals(type(fd), "userdata")
+    lt.assertEquals(process:fd(), fd)
+    local rd = socket.select({ fd })
+    lt.assertEquals(rd, { fd })
+    lt.assertEquals(process:wait(), 0)
+end
+
+function test_subprocess:test_usage()
+    local process = shell:runlua [[
+        local t = {}
+        for i = 1, 100000 do
+            t[i] = tostring(i)
+        end
+    ]]
+    lt.assertEquals(process:usage(), nil)
+    local status, usage = process:wait()
+    lt.assertEquals(status, 0)
+    lt.assertIsTable(usage)
+    lt.assertIsNumber(usage.utime)
+    lt.assertIsNumber(usage.stime)
+    lt.assertEquals(math.type(usage.maxrss), "integer")
+    lt.assertEquals(math.type(usage.inblock), "integer")
+    lt.assertEquals(math.type(usage.oublock), "integer")
+    lt.assertEquals(usage.maxrss > 0, true)
+    lt.assertEquals(process:usage(), usage)
+end
+
+function test_subprocess:test_limits()
+    if platform.os == "windows" then
+        lt.assertError(subprocess.spawn, { "cmd", limits = { nofile = 64 } })
+        lt.assertError(subprocess.spawn, { "cmd", cgroup = "C:/" })
+        return
+    end
+    local process = subprocess.spawn {
+        "sh", "-c", "ulimit -n",
+        stdout = true,
+        limits = { nofile = 64 },
+    }
+    lt.assertIsUserdata(process)
+    lt.assertEquals(process.stdout:read "a", "64\n")
+    lt.assertEquals(process:wait(), 0)
+    -- exec failures in the child are reported to the caller.
+    lt.assertEquals(subprocess.spawn { "bee-no-such-program", limits = { nofile = 64 } }, nil)
+    local process, errmsg = subprocess.spawn { "sh", cgroup = "/bee-no-such-cgroup" }
+    lt.assertEquals(process, nil)
+    lt.assertIsString(errmsg)
 end